@@ -98,12 +98,14 @@ SOURCES += \
     compiler/runner.cpp \
     customfileiconprovider.cpp \
     gdbmiresultparser.cpp \
+    filesearcher.cpp \
     compiler/compiler.cpp \
     compiler/compilermanager.cpp \
     compiler/executablerunner.cpp \
     compiler/filecompiler.cpp \
     compiler/stdincompiler.cpp \
     cpprefacter.cpp \
+    parser/cppincludegraph.cpp \
     parser/cppparser.cpp \
     parser/cpppreprocessor.cpp \
     parser/cpptokenizer.cpp \
@@ -116,6 +118,7 @@ SOURCES += \
     projectoptions.cpp \
     projecttemplate.cpp \
     settingsdialog/compilerautolinkwidget.cpp \
+    settingsdialog/compilercachewidget.cpp \
     settingsdialog/debuggeneralwidget.cpp \
     settingsdialog/editorautosavewidget.cpp \
     settingsdialog/editorcodecompletionwidget.cpp \
@@ -239,6 +242,8 @@ HEADERS += \
     cpprefacter.h \
     customfileiconprovider.h \
     gdbmiresultparser.h \
+    filesearcher.h \
+    parser/cppincludegraph.h \
     parser/cppparser.h \
     parser/cpppreprocessor.h \
     parser/cpptokenizer.h \
@@ -251,6 +256,7 @@ HEADERS += \
     projectoptions.h \
     projecttemplate.h \
     settingsdialog/compilerautolinkwidget.h \
+    settingsdialog/compilercachewidget.h \
     settingsdialog/debuggeneralwidget.h \
     settingsdialog/editorautosavewidget.h \
     settingsdialog/editorcodecompletionwidget.h \
@@ -358,6 +364,7 @@ HEADERS += \
 
 FORMS += \
     settingsdialog/compilerautolinkwidget.ui \
+    settingsdialog/compilercachewidget.ui \
     settingsdialog/debuggeneralwidget.ui \
     settingsdialog/editorautosavewidget.ui \
     settingsdialog/editorcodecompletionwidget.ui \
@@ -529,6 +536,7 @@ macos: {
     bundled_executable.files = \
         $$OUT_PWD/../tools/astyle/astyle \
         $$OUT_PWD/../tools/consolepauser/consolepauser \
+        $$OUT_PWD/../tools/redpanda-compile-cache/redpanda-compile-cache \
         $$OUT_PWD/../tools/redpanda-git-askpass/redpanda-git-askpass.app/Contents/MacOS/redpanda-git-askpass
     bundled_executable.path = Contents/MacOS
 
@@ -40,7 +40,8 @@ Compiler::Compiler(const QString &filename, bool silent, bool onlyCheckSyntax):
     mSilent(silent),
     mOnlyCheckSyntax(onlyCheckSyntax),
     mFilename(filename),
-    mRebuild(false)
+    mRebuild(false),
+    mUseCompileCache(false)
 {
 }
 
@@ -59,6 +60,9 @@ void Compiler::run()
         }
         mErrorCount = 0;
         mWarningCount = 0;
+        qint64 cacheHits, cacheMisses, cacheSize;
+        if (mUseCompileCache)
+            readCompileCacheStats(cacheHits, cacheMisses, cacheSize);
         QElapsedTimer timer;
         timer.start();
         runCommand(mCompiler, mArguments, mDirectory, pipedText());
@@ -76,6 +80,11 @@ void Compiler::run()
             log(tr("- Output Size: %1").arg(locale.formattedDataSize(QFileInfo(mOutputFile).size())));
         }
         log(tr("- Compilation Time: %1 secs").arg(timer.elapsed() / 1000.0));
+        if (mUseCompileCache) {
+            qint64 hits, misses, size;
+            readCompileCacheStats(hits, misses, size);
+            log(tr("- Compile Cache: %1 hits, %2 misses").arg(hits-cacheHits).arg(misses-cacheMisses));
+        }
     } catch (CompileError e) {
         emit compileErrorOccured(e.reason());
     }
@@ -744,6 +753,16 @@ void Compiler::runCommand(const QString &cmd, const QString  &arguments, const Q
     }
 }
 
+QString Compiler::compileCacheProgram()
+{
+    if (!pSettings->editor().enableCompileCache())
+        return QString();
+    QString program = includeTrailingPathDelimiter(pSettings->dirs().appLibexecDir())+COMPILE_CACHE_PROGRAM;
+    if (!fileExists(program))
+        return QString();
+    return program;
+}
+
 const std::shared_ptr<Project> &Compiler::project() const
 {
     return mProject;
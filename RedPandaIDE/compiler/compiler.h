@@ -84,6 +84,7 @@ protected:
     void log(const QString& msg);
     void error(const QString& msg);
     void runCommand(const QString& cmd, const QString& arguments, const QString& workingDir, const QByteArray& inputText=QByteArray());
+    QString compileCacheProgram();
 
 protected:
     bool mSilent;
@@ -101,6 +102,7 @@ protected:
     bool mRebuild;
     std::shared_ptr<Project> mProject;
     bool mSetLANG;
+    bool mUseCompileCache;
 
 private:
     bool mStop;
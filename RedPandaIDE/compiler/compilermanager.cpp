@@ -340,6 +340,9 @@ void CompilerManager::doRunProblem(const QString &filename, const QString &argum
     }
     OJProblemCasesRunner * execRunner = new OJProblemCasesRunner(filename,arguments,workDir,problemCases);
     mRunner = execRunner;
+    execRunner->setThreadCount(pSettings->executor().caseRunningThreads());
+    execRunner->setValidateOptions(pSettings->executor().ignoreSpacesWhenValidatingCases(),
+                                   pSettings->executor().caseFloatTolerance());
     if (pSettings->executor().enableCaseLimit()) {
         execRunner->setExecTimeout(pSettings->executor().caseTimeout());
         execRunner->setMemoryLimit(pSettings->executor().caseMemoryLimit()*1024); //convert kb to bytes
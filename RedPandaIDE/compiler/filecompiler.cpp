@@ -179,6 +179,9 @@ bool FileCompiler::prepareForCompile()
     log(tr("Processing %1 source file:").arg(strFileType));
     log("------------------");
     log(tr("%1 Compiler: %2").arg(strFileType).arg(mCompiler));
+
+    //the compile cache is not used here: a single file is compiled and linked in one step,
+    //and the linked executable depends on libraries the cache key can't cover
     log(tr("Command: %1 %2").arg(extractFileName(mCompiler)).arg(mArguments));
     mDirectory = extractFileDir(mFilename);
     return true;
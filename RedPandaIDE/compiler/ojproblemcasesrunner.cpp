@@ -19,18 +19,88 @@
 #include "../settings.h"
 #include "../systemconsts.h"
 #include "../widgets/ojproblemsetmodel.h"
+#include "../problems/problemcasevalidator.h"
+#include <QDir>
 #include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
 #include <QProcess>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QUuid>
+#include <QWaitCondition>
 #ifdef Q_OS_WINDOWS
 #include <psapi.h>
 #endif
 
+//wall time allowed for a case, relative to its time limit, when cases run in parallel
+#define PARALLEL_WALL_TIME_FACTOR 2
+//consolepauser flag to run the case and report its cpu time / peak memory
+#define CONSOLE_PAUSER_RUN_CASE "4"
+//output of a case kept for display; the whole output is still validated
+#define MAX_DISPLAY_OUTPUT_SIZE (4*1024*1024)
+
+class OJProblemCaseRunTask: public QRunnable {
+public:
+    explicit OJProblemCaseRunTask(OJProblemCasesRunner* runner, const POJProblemCase& problemCase):
+        problemCase(problemCase),
+        execTimeouted(false),
+        memoryExceeded(false),
+        errorOccurred(false),
+        passed(false),
+        error(QProcess::UnknownError),
+        mRunner(runner),
+        mDone(false) {
+        setAutoDelete(false);
+    }
+    void run() override {
+        mRunner->runCase(this);
+        QMutexLocker locker(&mMutex);
+        mDone = true;
+        mCondition.wakeAll();
+    }
+    //wait until the buffered output is full or the case is finished
+    bool waitForOutput(int msecs) {
+        QMutexLocker locker(&mMutex);
+        if (!mDone && mOutput.length()<mRunner->bufferSize())
+            mCondition.wait(&mMutex, msecs);
+        return mDone;
+    }
+    void appendOutput(const QByteArray& output) {
+        QMutexLocker locker(&mMutex);
+        mOutput.append(output);
+        if (mOutput.length()>=mRunner->bufferSize())
+            mCondition.wakeAll();
+    }
+    QByteArray takeOutput() {
+        QMutexLocker locker(&mMutex);
+        QByteArray output = mOutput;
+        mOutput.clear();
+        return output;
+    }
+public:
+    POJProblemCase problemCase;
+    bool execTimeouted;
+    bool memoryExceeded;
+    bool errorOccurred;
+    bool passed;
+    QProcess::ProcessError error;
+private:
+    OJProblemCasesRunner* mRunner;
+    QMutex mMutex;
+    QWaitCondition mCondition;
+    QByteArray mOutput;
+    bool mDone;
+};
 
 OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QString& arguments, const QString& workDir,
                                            const QVector<POJProblemCase>& problemCases, QObject *parent):
     Runner(filename,arguments,workDir,parent),
     mExecTimeout(0),
-    mMemoryLimit(0)
+    mMemoryLimit(0),
+    mThreadCount(1),
+    mIgnoreSpaces(false),
+    mFloatTolerance(0)
 {
     mProblemCases = problemCases;
     mBufferSize = 8192;
@@ -42,7 +112,10 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
                                            POJProblemCase problemCase, QObject *parent):
     Runner(filename,arguments,workDir,parent),
     mExecTimeout(0),
-    mMemoryLimit(0)
+    mMemoryLimit(0),
+    mThreadCount(1),
+    mIgnoreSpaces(false),
+    mFloatTolerance(0)
 {
     mProblemCases.append(problemCase);
     mBufferSize = 8192;
@@ -50,22 +123,54 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
     setWaitForFinishTime(100);
 }
 
-void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
+//runs in a worker thread of the pool; results are reported by reportCase() in case order
+void OJProblemCasesRunner::runCase(OJProblemCaseRunTask* task)
 {
-    emit caseStarted(problemCase->getId(),index, mProblemCases.count());
-    auto action = finally([this,&index, &problemCase]{
-        emit caseFinished(problemCase->getId(), index, mProblemCases.count());
-    });
+    POJProblemCase problemCase = task->problemCase;
+    problemCase->output.clear();
+    problemCase->runningTime = 0;
+    problemCase->runningMemory = 0;
+    if (mStop)
+        return;
     QProcess process;
-    bool errorOccurred = false;
+    ProblemCaseValidator validator;
     QByteArray readed;
-    QByteArray buffer;
     QByteArray output;
-    int noOutputTime = 0;
     QElapsedTimer elapsedTimer;
     bool execTimeouted = false;
+    bool memoryLimitHit = false;
+    bool outputTruncated = false;
+    auto keepOutput = [&](const QByteArray& data) {
+        if (outputTruncated || data.isEmpty())
+            return;
+        QByteArray kept = data;
+        if (output.length()+data.length()>MAX_DISPLAY_OUTPUT_SIZE) {
+            kept = data.left(MAX_DISPLAY_OUTPUT_SIZE-output.length());
+            kept.append(tr("\n(The output is too long. Only the first %1 MB is shown.)\n")
+                        .arg(MAX_DISPLAY_OUTPUT_SIZE/1024/1024).toLocal8Bit());
+            outputTruncated = true;
+        }
+        output.append(kept);
+        task->appendOutput(kept);
+    };
     process.setProgram(mFilename);
     process.setArguments(splitProcessCommand(mArguments));
+#ifdef Q_OS_LINUX
+    //let consolepauser run the case, so we can get the cpu time and memory usage from wait4()
+    QString caseResultFile;
+    if (canMeasureCPUTime()) {
+        caseResultFile = QDir(QDir::tempPath()).filePath(QUuid::createUuid().toString(QUuid::StringFormat::Id128)+".case");
+        QStringList arguments;
+        arguments.append(CONSOLE_PAUSER_RUN_CASE);
+        arguments.append(caseResultFile);
+        arguments.append(QString::number(mExecTimeout));
+        arguments.append(QString::number(mMemoryLimit/1024));
+        arguments.append(mFilename);
+        arguments.append(splitProcessCommand(mArguments));
+        process.setProgram(consolePauserPath());
+        process.setArguments(arguments);
+    }
+#endif
     process.setWorkingDirectory(mWorkDir);
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
     QString path = env.value("PATH");
@@ -88,9 +193,8 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
     process.connect(
                 &process, &QProcess::errorOccurred,
                 [&](){
-        errorOccurred= true;
+        task->errorOccurred= true;
     });
-    problemCase->output.clear();
     process.start();
     process.waitForStarted(5000);
 #ifdef Q_OS_WIN
@@ -107,41 +211,41 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
         process.waitForFinished(0);
     }
 
+    //other cases compete for the cpu, so only kill the process when the wall time is far beyond the limit;
+    //the verdict is made with the cpu time below.
+    qint64 wallTimeLimit = mExecTimeout;
+    if (mThreadCount>1)
+        wallTimeLimit *= PARALLEL_WALL_TIME_FACTOR;
+    validator.begin(problemCase, mIgnoreSpaces, mFloatTolerance);
     elapsedTimer.start();
     while (true) {
         if (process.bytesToWrite()==0 && !writeChannelClosed) {
             writeChannelClosed = true;
             process.closeWriteChannel();
         }
-        process.waitForFinished(mWaitForFinishTime);
+        process.waitForReadyRead(mWaitForFinishTime);
+        readed = process.readAll();
+        if (!readed.isEmpty()) {
+            keepOutput(readed);
+            validator.addOutput(readed);
+        }
         if (process.state()!=QProcess::Running) {
             break;
         }
         if (mExecTimeout>0) {
-            int msec = elapsedTimer.elapsed();
-            if (msec>mExecTimeout) {
+            if (elapsedTimer.elapsed()>wallTimeLimit) {
                 execTimeouted=true;
             }
         }
         if (mStop || execTimeouted) {
             process.terminate();
             process.kill();
+            //consolepauser may still be writing the result file
+            process.waitForFinished();
             break;
         }
-        if (errorOccurred)
+        if (task->errorOccurred)
             break;
-        readed = process.read(mBufferSize);
-        buffer += readed;
-        if (buffer.length()>=mBufferSize || noOutputTime > mOutputRefreshTime) {
-            if (!buffer.isEmpty()) {
-                emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
-                output.append(buffer);
-                buffer.clear();
-            }
-            noOutputTime = 0;
-        } else {
-            noOutputTime += mWaitForFinishTime;
-        }
     }
     problemCase->runningTime=elapsedTimer.elapsed();
     problemCase->runningMemory = 0;
@@ -163,43 +267,112 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
                     +(kernelTime.dwLowDateTime)+(userTime.dwLowDateTime);
             problemCase->runningTime=(double)t/10000;
         }
+        CloseHandle(hProcess);
+    }
+#elif defined(Q_OS_LINUX)
+    if (!caseResultFile.isEmpty()) {
+        if (process.state() == QProcess::NotRunning) {
+            //cpu time(ms) peak memory(kb) wait status memory limit hit
+            QList<QByteArray> usage = readFileToByteArray(caseResultFile).trimmed().split(' ');
+            if (usage.length()>=2) {
+                problemCase->runningTime = usage[0].toULongLong();
+                problemCase->runningMemory = usage[1].toULongLong()*1024;
+            }
+            if (usage.length()>=4)
+                memoryLimitHit = (usage[3].toInt()!=0);
+        }
+        QFile::remove(caseResultFile);
     }
 #endif
+    if (!execTimeouted && mExecTimeout>0 && problemCase->runningTime>(qulonglong)mExecTimeout)
+        execTimeouted = true;
+    task->execTimeouted = execTimeouted;
+    if (process.state() == QProcess::ProcessState::NotRunning) {
+        readed = process.readAll();
+        keepOutput(readed);
+        validator.addOutput(readed);
+    }
+    task->passed = validator.finish();
     if (execTimeouted) {
+        task->passed = false;
         problemCase->output = tr("Time limit exceeded!");
-        emit resetOutput(problemCase->getId(), problemCase->output);
-    } else if (mMemoryLimit>0 && problemCase->runningMemory>mMemoryLimit) {
+    } else if (memoryLimitHit || (mMemoryLimit>0 && problemCase->runningMemory>mMemoryLimit)) {
+        task->passed = false;
+        task->memoryExceeded = true;
         problemCase->output = tr("Memory limit exceeded!");
-        emit resetOutput(problemCase->getId(), problemCase->output);
     } else {
-        if (process.state() == QProcess::ProcessState::NotRunning)
-            buffer += process.readAll();
-        emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
-        output.append(buffer);
+        if (!mStop && process.state() == QProcess::NotRunning
+                && process.exitStatus() == QProcess::CrashExit) {
+            //keep what the program printed before it crashed
+            task->passed = false;
+            QByteArray note = tr("\n(Runtime error: the program crashed.)\n").toLocal8Bit();
+            output.append(note);
+            task->appendOutput(note);
+        }
         problemCase->output = QString::fromLocal8Bit(output);
+        task->error = process.error();
+    }
+}
 
-        if (errorOccurred) {
-            //qDebug()<<"process error:"<<process.error();
-            switch (process.error()) {
-            case QProcess::FailedToStart:
-                emit runErrorOccurred(tr("The runner process '%1' failed to start.").arg(mFilename));
-                break;
-    //        case QProcess::Crashed:
-    //            if (!mStop)
-    //                emit runErrorOccurred(tr("The runner process crashed after starting successfully."));
-    //            break;
-            case QProcess::Timedout:
-                emit runErrorOccurred(tr("The last waitFor...() function timed out."));
-                break;
-            case QProcess::WriteError:
-                emit runErrorOccurred(tr("An error occurred when attempting to write to the runner process."));
-                break;
-            case QProcess::ReadError:
-                emit runErrorOccurred(tr("An error occurred when attempting to read from the runner process."));
-                break;
-            default:
-                break;
-            }
+QString OJProblemCasesRunner::consolePauserPath() const
+{
+    return includeTrailingPathDelimiter(pSettings->dirs().appLibexecDir())+CONSOLE_PAUSER;
+}
+
+//the time verdict needs the cpu time; the wall time is meaningless when cases compete for the cpu
+bool OJProblemCasesRunner::canMeasureCPUTime() const
+{
+#ifdef Q_OS_WIN
+    return true;
+#elif defined(Q_OS_LINUX)
+    return fileExists(consolePauserPath()) && fileExists(mFilename);
+#else
+    return false;
+#endif
+}
+
+void OJProblemCasesRunner::reportCase(int index, OJProblemCaseRunTask *task)
+{
+    POJProblemCase problemCase = task->problemCase;
+    emit caseStarted(problemCase->getId(),index, mProblemCases.count());
+    auto action = finally([this,&index, &problemCase, task]{
+        emit caseFinished(problemCase->getId(), index, mProblemCases.count(), task->passed);
+    });
+    QByteArray buffer;
+    while (true) {
+        bool done = task->waitForOutput(mOutputRefreshTime);
+        buffer = task->takeOutput();
+        if (done)
+            break;
+        if (!buffer.isEmpty())
+            emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
+    }
+    if (task->execTimeouted || task->memoryExceeded) {
+        emit resetOutput(problemCase->getId(), problemCase->output);
+        return;
+    }
+    emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
+    if (task->errorOccurred) {
+        //qDebug()<<"process error:"<<process.error();
+        switch (task->error) {
+        case QProcess::FailedToStart:
+            emit runErrorOccurred(tr("The runner process '%1' failed to start.").arg(mFilename));
+            break;
+//        case QProcess::Crashed:
+//            if (!mStop)
+//                emit runErrorOccurred(tr("The runner process crashed after starting successfully."));
+//            break;
+        case QProcess::Timedout:
+            emit runErrorOccurred(tr("The last waitFor...() function timed out."));
+            break;
+        case QProcess::WriteError:
+            emit runErrorOccurred(tr("An error occurred when attempting to write to the runner process."));
+            break;
+        case QProcess::ReadError:
+            emit runErrorOccurred(tr("An error occurred when attempting to read from the runner process."));
+            break;
+        default:
+            break;
         }
     }
 }
@@ -210,12 +383,41 @@ void OJProblemCasesRunner::run()
     auto action = finally([this]{
         emit terminated();
     });
-    for (int i=0; i < mProblemCases.size(); i++) {
+    //cases are independent, so they run in the pool; the results are still reported in order
+    if (!canMeasureCPUTime())
+        mThreadCount = 1;
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1,mThreadCount));
+    QVector<std::shared_ptr<OJProblemCaseRunTask>> tasks;
+    foreach (const POJProblemCase& problemCase, mProblemCases) {
+        std::shared_ptr<OJProblemCaseRunTask> task = std::make_shared<OJProblemCaseRunTask>(this, problemCase);
+        tasks.append(task);
+        pool.start(task.get());
+    }
+    for (int i=0; i < tasks.size(); i++) {
         if (mStop)
             break;
-        POJProblemCase problemCase = mProblemCases[i];
-        runCase(i,problemCase);
+        reportCase(i,tasks[i].get());
     }
+    //tasks are owned here, so wait for the running ones before releasing them
+    pool.clear();
+    pool.waitForDone();
+}
+
+int OJProblemCasesRunner::threadCount() const
+{
+    return mThreadCount;
+}
+
+void OJProblemCasesRunner::setThreadCount(int newThreadCount)
+{
+    mThreadCount = newThreadCount;
+}
+
+void OJProblemCasesRunner::setValidateOptions(bool ignoreSpaces, double floatTolerance)
+{
+    mIgnoreSpaces = ignoreSpaces;
+    mFloatTolerance = floatTolerance;
 }
 
 int OJProblemCasesRunner::execTimeout() const
@@ -21,6 +21,8 @@
 #include <QVector>
 #include "../problems/ojproblemset.h"
 
+class OJProblemCaseRunTask;
+
 class OJProblemCasesRunner : public Runner
 {
     Q_OBJECT
@@ -49,13 +51,22 @@ public:
 
     void setMemoryLimit(size_t limit);
 
+    //max number of cases running at the same time
+    int threadCount() const;
+    void setThreadCount(int newThreadCount);
+
+    void setValidateOptions(bool ignoreSpaces, double floatTolerance);
+
 signals:
     void caseStarted(const QString &caseId, int current, int total);
-    void caseFinished(const QString &caseId, int current, int total);
+    void caseFinished(const QString &caseId, int current, int total, bool passed);
     void newOutputGetted(const QString &caseId, const QString &newOutputLine);
     void resetOutput(const QString &caseId, const QString &newOutputLine);
 private:
-    void runCase(int index, POJProblemCase problemCase);
+    void runCase(OJProblemCaseRunTask* task);
+    void reportCase(int index, OJProblemCaseRunTask* task);
+    QString consolePauserPath() const;
+    bool canMeasureCPUTime() const;
 private:
     QVector<POJProblemCase> mProblemCases;
 
@@ -67,6 +78,10 @@ private:
     int mOutputRefreshTime;
     int mExecTimeout;
     size_t mMemoryLimit;
+    int mThreadCount;
+    bool mIgnoreSpaces;
+    double mFloatTolerance;
+    friend class OJProblemCaseRunTask;
 };
 
 #endif // OJPROBLEMCASESRUNNER_H
@@ -235,6 +235,14 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
 
     writeln(file,"CPP      = " + extractFileName(compilerSet()->cppCompiler()));
     writeln(file,"CC       = " + extractFileName(compilerSet()->CCompiler()));
+    QString cacheProgram = compileCacheProgram();
+    mUseCompileCache = !mOnlyCheckSyntax && !cacheProgram.isEmpty();
+    if (mUseCompileCache) {
+        writeln(file,QString("COMPILE_CACHE = %1 %2 %3")
+                .arg(genMakePath1(cacheProgram),
+                     genMakePath1(compileCacheDir()))
+                .arg(pSettings->editor().compileCacheMaxSize()));
+    }
 #ifdef Q_OS_WIN
     writeln(file,"WINDRES  = " + extractFileName(compilerSet()->resourceCompiler()));
 #endif
@@ -409,6 +417,9 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
 
         writeln(file,objStr);
 
+        // Object files are compiled through the compile cache
+        QString compileCache = mUseCompileCache?"$(COMPILE_CACHE) ":"";
+
         // Write custom build command
         if (unit->overrideBuildCmd() && !unit->buildCmd().isEmpty()) {
             QString BuildCmd = unit->buildCmd();
@@ -473,9 +484,9 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
                         writeln(file, "\t(CC) -c " + genMakePath1(shortFileName) + " $(CFLAGS) " + encodingStr);
                 } else {
                     if (unit->compileCpp())
-                        writeln(file, "\t$(CPP) -c " + genMakePath1(shortFileName) + " -o " + objFileName2 + " $(CXXFLAGS) " + encodingStr);
+                        writeln(file, "\t" + compileCache + "$(CPP) -c " + genMakePath1(shortFileName) + " -o " + objFileName2 + " $(CXXFLAGS) " + encodingStr);
                     else
-                        writeln(file, "\t$(CC) -c " + genMakePath1(shortFileName) + " -o " + objFileName2 + " $(CFLAGS) " + encodingStr);
+                        writeln(file, "\t" + compileCache + "$(CC) -c " + genMakePath1(shortFileName) + " -o " + objFileName2 + " $(CFLAGS) " + encodingStr);
                 }
             } else if (fileType==FileType::GAS) {
                 if (!mOnlyCheckSyntax) {
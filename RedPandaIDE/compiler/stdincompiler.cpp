@@ -16,10 +16,140 @@
  */
 #include "stdincompiler.h"
 #include "compilermanager.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutex>
+#include <QProcess>
+#include <QSet>
 #include <QTextCodec>
+#include <algorithm>
 #include "qt_utils/charsetinfo.h"
+#include "../systemconsts.h"
+
+#define PCH_HEADER_NAME "stable.h"
+#define PCH_BUILD_TIMEOUT 120000
+//headers the pch was built from, as "size mtime path" lines
+#define PCH_DEPENDENCIES_NAME "stable.h.deps"
+//precompiled headers are large, keep only the most recently used ones
+#define PCH_MAX_ENTRIES 4
+
+//keys of headers that failed to precompile, so we don't retry them on every check
+static QMutex failedPchMutex;
+static QSet<QString> failedPchKeys;
+
+//Count the leading lines made of #include <...>, blank lines and // comments.
+//Returns the line count up to the last such include, and collects the include lines.
+static int stableIncludeBlock(const QStringList& lines, QString& includes)
+{
+    int count = 0;
+    for (int i=0;i<lines.count();i++) {
+        QString line = lines[i].trimmed();
+        if (line.isEmpty() || line.startsWith("//"))
+            continue;
+        if (!line.startsWith('#'))
+            break;
+        line = line.mid(1).trimmed();
+        if (!line.startsWith("include"))
+            break;
+        line = line.mid(7).trimmed();
+        int pos = line.indexOf('>');
+        if (!line.startsWith('<') || pos<0)
+            break;
+        QString rest = line.mid(pos+1).trimmed();
+        if (!rest.isEmpty() && !rest.startsWith("//"))
+            break;
+        includes += "#include "+line.left(pos+1)+"\n";
+        count = i+1;
+    }
+    return count;
+}
+
+//Read the headers from the make rule written by -MD, and record their sizes and times.
+static bool writePchDependencies(const QString& makeRuleFile, const QString& dependenciesFile)
+{
+    QFile ruleFile(makeRuleFile);
+    if (!ruleFile.open(QFile::ReadOnly))
+        return false;
+    QString rule = QString::fromLocal8Bit(ruleFile.readAll());
+    ruleFile.close();
+    rule.replace("\\\r\n"," ");
+    rule.replace("\\\n"," ");
+    QStringList headers;
+    QString current;
+    for (int i=0;i<rule.length();i++) {
+        QChar ch = rule[i];
+        if (ch=='\\' && i+1<rule.length() && rule[i+1]==' ') {
+            current+=' ';
+            i++;
+        } else if (ch.isSpace()) {
+            if (!current.isEmpty())
+                headers.append(current);
+            current.clear();
+        } else {
+            current+=ch;
+        }
+    }
+    if (!current.isEmpty())
+        headers.append(current);
+    //the first one is the target
+    if (!headers.isEmpty() && headers.front().endsWith(':'))
+        headers.pop_front();
+    QFile file(dependenciesFile);
+    if (!file.open(QFile::WriteOnly|QFile::Truncate))
+        return false;
+    foreach (const QString& header, headers) {
+        QFileInfo info(header);
+        file.write(QString("%1 %2 %3\n")
+                   .arg(info.size())
+                   .arg(info.lastModified().toMSecsSinceEpoch())
+                   .arg(info.absoluteFilePath()).toUtf8());
+    }
+    return true;
+}
+
+//gcc doesn't check the headers when it loads a pch, so we check them before reusing it
+static bool pchDependenciesChanged(const QString& dependenciesFile)
+{
+    QFile file(dependenciesFile);
+    if (!file.open(QFile::ReadOnly))
+        return true;
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty())
+            continue;
+        QStringList fields = line.split(' ');
+        if (fields.count()<3)
+            return true;
+        QFileInfo info(line.section(' ',2));
+        if (!info.exists()
+                || info.size()!=fields[0].toLongLong()
+                || info.lastModified().toMSecsSinceEpoch()!=fields[1].toLongLong())
+            return true;
+    }
+    return false;
+}
+
+//Remove the least recently used precompiled headers. The time of the dependency file
+//is the last used time of an entry.
+static void prunePchCache(const QDir& cacheDir)
+{
+    QFileInfoList entries = cacheDir.entryInfoList(QDir::Dirs|QDir::NoDotAndDotDot);
+    if (entries.count()<=PCH_MAX_ENTRIES)
+        return;
+    auto lastUsed = [](const QFileInfo& entry) {
+        QFileInfo info(QDir(entry.absoluteFilePath()).absoluteFilePath(PCH_DEPENDENCIES_NAME));
+        return info.exists()?info.lastModified():entry.lastModified();
+    };
+    std::sort(entries.begin(),entries.end(),[&lastUsed](const QFileInfo& e1, const QFileInfo& e2) {
+        return lastUsed(e1) > lastUsed(e2);
+    });
+    for (int i=PCH_MAX_ENTRIES;i<entries.count();i++) {
+        QDir(entries[i].absoluteFilePath()).removeRecursively();
+    }
+}
 
 StdinCompiler::StdinCompiler(const QString &filename,const QByteArray& encoding, const QString& content,bool silent, bool onlyCheckSyntax):
     Compiler(filename,silent, onlyCheckSyntax),
@@ -42,8 +172,10 @@ bool StdinCompiler::prepareForCompile()
     if (fileType == FileType::Other)
         fileType = FileType::CppSource;
     QString strFileType;
+    QString charsetArgument;
     if (mEncoding!=ENCODING_ASCII) {
-        mArguments += getCharsetArgument(mEncoding,fileType, mOnlyCheckSyntax);
+        charsetArgument = getCharsetArgument(mEncoding,fileType, mOnlyCheckSyntax);
+        mArguments += charsetArgument;
     }
     switch(fileType) {
     case FileType::CSource:
@@ -85,6 +217,9 @@ bool StdinCompiler::prepareForCompile()
             return false;
     }
 
+    if (mOnlyCheckSyntax && fileType != FileType::GAS)
+        usePrecompiledHeader(fileType, charsetArgument);
+
     log(tr("Processing %1 source file:").arg(strFileType));
     log("------------------");
     log(tr("%1 Compiler: %2").arg(strFileType).arg(mCompiler));
@@ -106,6 +241,111 @@ QByteArray StdinCompiler::pipedText()
     }
 }
 
+void StdinCompiler::usePrecompiledHeader(FileType fileType, const QString& charsetArgument)
+{
+    CompilerType compilerType = compilerSet()->compilerType();
+    if (compilerType != CompilerType::GCC && compilerType != CompilerType::GCC_UTF8)
+        return;
+    QStringList lines = textToLines(mContent);
+    QString includes;
+    int includeLines = stableIncludeBlock(lines, includes);
+    if (includeLines == 0)
+        return;
+
+    //gcc won't write the pch when -fsyntax-only is given
+    QString language;
+    QString arguments = charsetArgument;
+    if (fileType == FileType::CSource) {
+        language = "c-header";
+        arguments += getCCompileArguments(false);
+        arguments += getCIncludeArguments();
+    } else {
+        language = "c++-header";
+        arguments += getCppCompileArguments(false);
+        arguments += getCppIncludeArguments();
+    }
+    arguments += getProjectIncludeArguments();
+
+    //the pch is only valid for the same compiler, options and includes;
+    //the headers themselves are checked against the dependency file before reuse
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(mCompiler.toUtf8());
+    hash.addData(QByteArray::number(QFileInfo(mCompiler).lastModified().toMSecsSinceEpoch()));
+    hash.addData(language.toUtf8());
+    hash.addData(arguments.toUtf8());
+    hash.addData(includes.toUtf8());
+    QString key = QString::fromLatin1(hash.result().toHex());
+
+    QMutexLocker locker(&failedPchMutex);
+    if (failedPchKeys.contains(key))
+        return;
+    QDir dir(QDir::tempPath());
+    QString pchDir = QString(DEV_PCH_CACHE_DIR) + QDir::separator() + key;
+    if (!dir.mkpath(pchDir))
+        return;
+    dir.cd(pchDir);
+    QString headerFile = dir.absoluteFilePath(PCH_HEADER_NAME);
+    QString pchFile = headerFile + ".gch";
+    QString dependenciesFile = dir.absoluteFilePath(PCH_DEPENDENCIES_NAME);
+    if (fileExists(pchFile) && pchDependenciesChanged(dependenciesFile))
+        QFile::remove(pchFile);
+    if (!fileExists(pchFile)) {
+        QFile file(headerFile);
+        if (!file.open(QFile::WriteOnly|QFile::Truncate)
+                || file.write(includes.toUtf8())<0) {
+            failedPchKeys.insert(key);
+            return;
+        }
+        file.close();
+        log(tr("Precompiling header for syntax checking..."));
+        QString tempFile = pchFile + ".tmp";
+        QString makeRuleFile = pchFile + ".d";
+        QProcess process;
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        QString cmdDir = extractFileDir(mCompiler);
+        if (!cmdDir.isEmpty())
+            env.insert("PATH",cmdDir + PATH_SEPARATOR + env.value("PATH"));
+        process.setProcessEnvironment(env);
+        process.setProgram(mCompiler);
+        process.setArguments(splitProcessCommand(
+                                 QString(" -x %1 \"%2\" -o \"%3\" -MD -MF \"%4\"")
+                                 .arg(language, headerFile, tempFile, makeRuleFile)
+                                 + arguments));
+        process.setWorkingDirectory(extractFileDir(mFilename));
+        process.start();
+        if (!process.waitForFinished(PCH_BUILD_TIMEOUT)
+                || process.exitStatus()!=QProcess::NormalExit
+                || process.exitCode()!=0
+                || !writePchDependencies(makeRuleFile, dependenciesFile)
+                || !QFile::rename(tempFile, pchFile)) {
+            process.kill();
+            QFile::remove(tempFile);
+            QFile::remove(makeRuleFile);
+            failedPchKeys.insert(key);
+            return;
+        }
+        QFile::remove(makeRuleFile);
+        QDir cacheDir(QDir::tempPath());
+        if (cacheDir.cd(DEV_PCH_CACHE_DIR))
+            prunePchCache(cacheDir);
+    } else {
+        //mark the entry as used
+        QFile file(dependenciesFile);
+        if (file.open(QFile::ReadWrite)) {
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            file.close();
+        }
+    }
+    //blank the included lines instead of removing them, to keep the line numbers of issues
+    for (int i=0;i<includeLines;i++) {
+        QString line = lines[i].trimmed();
+        if (!line.isEmpty() && !line.startsWith("//"))
+            lines[i].clear();
+    }
+    mContent = lines.join("\n");
+    mArguments += QString(" -include \"%1\"").arg(headerFile);
+}
+
 bool StdinCompiler::prepareForRebuild()
 {
     return true;
@@ -31,6 +31,8 @@ public:
 protected:
     bool prepareForCompile() override;
 
+private:
+    void usePrecompiledHeader(FileType fileType, const QString& charsetArgument);
 private:
     QString mContent;
     QByteArray mEncoding;
@@ -33,6 +33,8 @@
 #include <QJsonObject>
 #include "widgets/signalmessagedialog.h"
 
+#define MAX_RUNNING_DEBUG_COMMANDS 8
+
 Debugger::Debugger(QObject *parent) : QObject(parent),
     mForceUTF8(false),
     mDebuggerType(DebuggerType::GDB),
@@ -967,8 +969,9 @@ DebugReader::DebugReader(Debugger* debugger, QObject *parent) : QThread(parent),
     mStartSemaphore(0)
 {
     mDebugger = debugger;
-    mProcess = std::make_shared<QProcess>();
-    mCmdRunning = false;
+    mNextToken = 1;
+    mExclusiveCmdRunning = false;
+    mLastExclusiveCmdSource = DebugCommandSource::Other;
     mAsyncUpdated = false;
 }
 
@@ -980,9 +983,13 @@ void DebugReader::postCommand(const QString &Command, const QString &Params,
     pCmd->command = Command;
     pCmd->params = Params;
     pCmd->source = Source;
+    pCmd->token = 0;
     mCmdQueue.enqueue(pCmd);
-//    if (!mCmdRunning)
-    //        runNextCmd();
+    //commands are written to gdb in the reader thread
+    if (mProcess)
+        QMetaObject::invokeMethod(mProcess.get(),[this]{
+            runNextCmd();
+        }, Qt::QueuedConnection);
 }
 
 void DebugReader::registerInferiorStoppedCommand(const QString &Command, const QString &Params)
@@ -992,6 +999,7 @@ void DebugReader::registerInferiorStoppedCommand(const QString &Command, const Q
     pCmd->command = Command;
     pCmd->params = Params;
     pCmd->source = DebugCommandSource::Other;
+    pCmd->token = 0;
     mInferiorStoppedHookCommands.append(pCmd);
 }
 
@@ -1086,16 +1094,17 @@ void DebugReader::processConsoleOutput(const QByteArray& line)
     }
 }
 
-void DebugReader::processResult(const QByteArray &result)
+void DebugReader::processResult(const QByteArray &line, int start)
 {
     GDBMIResultParser parser;
     GDBMIResultType resultType;
-    GDBMIResultParser::ParseObject multiValues;
+    GDBMIResultParser::ParseTree tree;
     if (!mCurrentCmd)
         return;
-    bool parseOk = parser.parse(result, mCurrentCmd->command, resultType,multiValues);
+    bool parseOk = parser.parse(line, start, mCurrentCmd->command, resultType,tree);
     if (!parseOk)
         return;
+    GDBMIResultParser::ParseObject multiValues = tree.root();
     switch(resultType) {
     case GDBMIResultType::BreakpointTable:
     case GDBMIResultType::Locals:
@@ -1142,10 +1151,11 @@ void DebugReader::processResult(const QByteArray &result)
 void DebugReader::processExecAsyncRecord(const QByteArray &line)
 {
     QByteArray result;
-    GDBMIResultParser::ParseObject multiValues;
+    GDBMIResultParser::ParseTree tree;
     GDBMIResultParser parser;
-    if (!parser.parseAsyncResult(line,result,multiValues))
+    if (!parser.parseAsyncResult(line,result,tree))
         return;
+    GDBMIResultParser::ParseObject multiValues = tree.root();
     if (result == "running") {
         mInferiorRunning = true;
         mCurrentAddress=0;
@@ -1198,7 +1208,12 @@ void DebugReader::processExecAsyncRecord(const QByteArray &line)
             }
         }
         runInferiorStoppedHook();
-        if (mCurrentCmd && mCurrentCmd->source == DebugCommandSource::Console)
+        DebugCommandSource source;
+        {
+            QMutexLocker locker(&mCmdQueueMutex);
+            source = mLastExclusiveCmdSource;
+        }
+        if (source == DebugCommandSource::Console)
             emit inferiorStopped(mCurrentFile, mCurrentLine, false);
         else
             emit inferiorStopped(mCurrentFile, mCurrentLine, true);
@@ -1230,8 +1245,7 @@ void DebugReader::processResultRecord(const QByteArray &line)
             || line.startsWith("^running")) {
         int pos = line.indexOf(',');
         if (pos>=0) {
-            QByteArray result = line.mid(pos+1);
-            processResult(result);
+            processResult(line, pos+1);
         } else if (mCurrentCmd && !(mCurrentCmd->command.startsWith('-'))) {
             if (mCurrentCmd->command == "disas") {
                  QStringList disOutput = mConsoleOutput;
@@ -1251,7 +1265,7 @@ void DebugReader::processResultRecord(const QByteArray &line)
     }
 }
 
-void DebugReader::processDebugOutput(const QByteArray& debugOutput)
+void DebugReader::processDebugOutput(const QList<QByteArray>& lines)
 {
     // Only update once per update at most
     //WatchView.Items.BeginUpdate;
@@ -1264,13 +1278,14 @@ void DebugReader::processDebugOutput(const QByteArray& debugOutput)
     mSignalReceived = false;
     mUpdateCPUInfo = false;
     mReceivedSFWarning = false;
-    QList<QByteArray> lines = splitByteArrayToLines(debugOutput);
+    mCurrentCmd = nullptr;
 
     for (int i=0;i<lines.count();i++) {
          QByteArray line = lines[i];
          if (pSettings->debugger().showDetailLog())
             mFullOutput.append(line);
-         line = removeToken(line);
+         int token;
+         line = removeToken(line, token);
          if (line.isEmpty()) {
              continue;
          }
@@ -1282,6 +1297,14 @@ void DebugReader::processDebugOutput(const QByteArray& debugOutput)
          case '&': // log stream output
              break;
          case '^': // result record
+         {
+             //results come in the order commands are sent, so an untagged result belongs to the oldest command
+             QMutexLocker locker(&mCmdQueueMutex);
+             if (mRunningCmds.contains(token))
+                 mCurrentCmd = mRunningCmds.take(token);
+             else if (!mRunningCmds.isEmpty())
+                 mCurrentCmd = mRunningCmds.take(mRunningCmds.firstKey());
+         }
              processResultRecord(line);
              break;
          case '*': // exec async output
@@ -1293,14 +1316,18 @@ void DebugReader::processDebugOutput(const QByteArray& debugOutput)
          }
     }
     emit parseFinished();
+    if (mCurrentCmd && mCurrentCmd->source!=DebugCommandSource::HeartBeat)
+        emit cmdFinished();
     mConsoleOutput.clear();
     mFullOutput.clear();
 }
 
 void DebugReader::runInferiorStoppedHook()
 {
+    QMutexLocker locker(&mCmdQueueMutex);
     foreach (const PDebugCommand& cmd, mInferiorStoppedHookCommands) {
-        mCmdQueue.push_front(cmd);
+        //each run gets its own token
+        mCmdQueue.push_front(std::make_shared<DebugCommand>(*cmd));
     }
 }
 
@@ -1308,61 +1335,100 @@ void DebugReader::runNextCmd()
 {
     QMutexLocker locker(&mCmdQueueMutex);
 
-    if (mCurrentCmd) {
-        DebugCommandSource commandSource = mCurrentCmd->source;
-        mCurrentCmd=nullptr;
-        if (commandSource!=DebugCommandSource::HeartBeat)
-            emit cmdFinished();
-    }
+    if (!mProcess)
+        return;
     if (mCmdQueue.isEmpty()) {
-        if (pSettings->debugger().useGDBServer() && mInferiorRunning && !mAsyncUpdated) {
+        if (mRunningCmds.isEmpty() && pSettings->debugger().useGDBServer() && mInferiorRunning && !mAsyncUpdated) {
             mAsyncUpdated = true;
             QTimer::singleShot(50,this,&DebugReader::asyncUpdate);
         }
         return;
     }
 
-    PDebugCommand pCmd = mCmdQueue.dequeue();
-    mCmdRunning = true;
-    mCurrentCmd = pCmd;
-    if (pCmd->source!=DebugCommandSource::HeartBeat)
-        emit cmdStarted();
-
-    QByteArray s;
-    QByteArray params;
-    s=pCmd->command.toLocal8Bit();
-    if (!pCmd->params.isEmpty()) {
-        params = pCmd->params.toLocal8Bit();
+    //keep several commands in flight, gdb runs them in order
+    while (!mCmdQueue.isEmpty() && mRunningCmds.count()<MAX_RUNNING_DEBUG_COMMANDS) {
+        bool exclusive = isExclusiveCmd(mCmdQueue.head());
+        if (!mRunningCmds.isEmpty() && (exclusive || mExclusiveCmdRunning))
+            break;
+        PDebugCommand pCmd = mCmdQueue.dequeue();
+        pCmd->token = mNextToken++;
+        mRunningCmds.insert(pCmd->token,pCmd);
+        mExclusiveCmdRunning = exclusive;
+        if (exclusive)
+            mLastExclusiveCmdSource = pCmd->source;
+        if (pCmd->source!=DebugCommandSource::HeartBeat)
+            emit cmdStarted();
+
+        QByteArray s;
+        QByteArray params;
+        s=QByteArray::number(pCmd->token)+pCmd->command.toLocal8Bit();
+        if (!pCmd->params.isEmpty()) {
+            params = pCmd->params.toLocal8Bit();
+        }
+
+        //clang compatibility
+        if (mDebugger->forceUTF8()) {
+            params = pCmd->params.toUtf8();
+        }
+        if (pCmd->command == "-var-create") {
+            //hack for variable creation,to easy remember var expression
+            if (mDebugger->debuggerType()==DebuggerType::LLDB_MI)
+                params = " - * "+params;
+            else
+                params = " - @ "+params;
+        } else if (pCmd->command == "-var-list-children") {
+            //hack for list variable children,to easy remember var expression
+            params = " --all-values \"" + params+'\"';
+        }
+        s+=" "+params;
+        s+= "\n";
+        if (mProcess->write(s)<0) {
+            emit writeToDebugFailed();
+        }
+
+    //  if devDebugger.ShowCommandLog or pCmd^.ShowInConsole then begin
+        if (pSettings->debugger().enableDebugConsole() ) {
+            //update debug console
+            if (pSettings->debugger().showDetailLog()
+                    && pCmd->source != DebugCommandSource::Console) {
+                emit changeDebugConsoleLastLine(pCmd->command + ' ' + params);
+            }
+        }
     }
+}
 
-    //clang compatibility
-    if (mDebugger->forceUTF8()) {
-        params = pCmd->params.toUtf8();
-    }
-    if (pCmd->command == "-var-create") {
-        //hack for variable creation,to easy remember var expression
-        if (mDebugger->debuggerType()==DebuggerType::LLDB_MI)
-            params = " - * "+params;
-        else
-            params = " - @ "+params;
-    } else if (pCmd->command == "-var-list-children") {
-        //hack for list variable children,to easy remember var expression
-        params = " --all-values \"" + params+'\"';
-    }
-    s+=" "+params;
-    s+= "\n";
-    if (mProcess->write(s)<0) {
-        emit writeToDebugFailed();
-    }
+bool DebugReader::isExclusiveCmd(const PDebugCommand &cmd)
+{
+    //commands that may resume the inferior or change what other commands see
+    if (cmd->source == DebugCommandSource::Console)
+        return true;
+    if (!cmd->command.startsWith('-'))
+        return true;
+    return cmd->command.startsWith("-exec")
+            || cmd->command.startsWith("-target")
+            || cmd->command.startsWith("-file")
+            || cmd->command.startsWith("-gdb-exit");
+}
 
-//  if devDebugger.ShowCommandLog or pCmd^.ShowInConsole then begin
-    if (pSettings->debugger().enableDebugConsole() ) {
-        //update debug console
-        if (pSettings->debugger().showDetailLog()
-                && pCmd->source != DebugCommandSource::Console) {
-            emit changeDebugConsoleLastLine(pCmd->command + ' ' + params);
+void DebugReader::readOutput()
+{
+    mOutputBuffer += mProcess->readAll();
+    int pos = mOutputBuffer.lastIndexOf('\n');
+    if (pos<0)
+        return;
+    QList<QByteArray> lines = mOutputBuffer.left(pos).split('\n');
+    mOutputBuffer.remove(0,pos+1);
+    foreach (QByteArray line, lines) {
+        if (line.endsWith('\r'))
+            line.chop(1);
+        mOutputLines.append(line);
+        //gdb prints a prompt after each result or async record
+        if (line.trimmed() == "(gdb)") {
+            processDebugOutput(mOutputLines);
+            mOutputLines.clear();
         }
     }
+    runNextCmd();
 }
 
 QStringList DebugReader::tokenize(const QString &s)
@@ -1461,16 +1527,6 @@ QStringList DebugReader::tokenize(const QString &s)
     return result;
 }
 
-bool DebugReader::outputTerminated(const QByteArray &text)
-{
-    QStringList lines = textToLines(QString::fromUtf8(text));
-    foreach (const QString& line,lines) {
-        if (line.trimmed() == "(gdb)")
-            return true;
-    }
-    return false;
-}
-
 void DebugReader::handleBreakpoint(const GDBMIResultParser::ParseObject& breakpoint)
 {
     QString filename;
@@ -1501,10 +1557,10 @@ void DebugReader::handleFrame(const GDBMIResultParser::ParseValue &frame)
     }
 }
 
-void DebugReader::handleStack(const QList<GDBMIResultParser::ParseValue> & stack)
+void DebugReader::handleStack(const GDBMIResultParser::ParseArray & stack)
 {
     mDebugger->backtraceModel()->clear();
-    foreach (const GDBMIResultParser::ParseValue& frameValue, stack) {
+    for (const GDBMIResultParser::ParseValue& frameValue : stack) {
         GDBMIResultParser::ParseObject frameObject = frameValue.object();
         PTrace trace = std::make_shared<Trace>();
         trace->funcname = frameObject["func"].value();
@@ -1519,10 +1575,10 @@ void DebugReader::handleStack(const QList<GDBMIResultParser::ParseValue> & stack
     }
 }
 
-void DebugReader::handleLocalVariables(const QList<GDBMIResultParser::ParseValue> &variables)
+void DebugReader::handleLocalVariables(const GDBMIResultParser::ParseArray &variables)
 {
     QStringList locals;
-    foreach (const GDBMIResultParser::ParseValue& varValue, variables) {
+    for (const GDBMIResultParser::ParseValue& varValue : variables) {
         GDBMIResultParser::ParseObject varObject = varValue.object();
         locals.append(
                     QString("%1 = %2")
@@ -1539,14 +1595,14 @@ void DebugReader::handleEvaluation(const QString &value)
     emit evalUpdated(value);
 }
 
-void DebugReader::handleMemory(const QList<GDBMIResultParser::ParseValue> &rows)
+void DebugReader::handleMemory(const GDBMIResultParser::ParseArray &rows)
 {
     QStringList memory;
-    foreach (const GDBMIResultParser::ParseValue& row, rows) {
+    for (const GDBMIResultParser::ParseValue& row : rows) {
         GDBMIResultParser::ParseObject rowObject = row.object();
-        QList<GDBMIResultParser::ParseValue> data = rowObject["data"].array();
+        GDBMIResultParser::ParseArray data = rowObject["data"].array();
         QStringList values;
-        foreach (const GDBMIResultParser::ParseValue& val, data) {
+        for (const GDBMIResultParser::ParseValue& val : data) {
             values.append(val.value());
         }
         memory.append(QString("%1 %2")
@@ -1555,10 +1611,10 @@ void DebugReader::handleMemory(const QList<GDBMIResultParser::ParseValue> &rows)
     emit memoryUpdated(memory);
 }
 
-void DebugReader::handleRegisterNames(const QList<GDBMIResultParser::ParseValue> &names)
+void DebugReader::handleRegisterNames(const GDBMIResultParser::ParseArray &names)
 {
     QStringList nameList;
-    foreach (const GDBMIResultParser::ParseValue& nameValue, names) {
+    for (const GDBMIResultParser::ParseValue& nameValue : names) {
 //        QString text = nameValue.value().trimmed();
 //        if (!text.isEmpty())
             nameList.append(nameValue.value());
@@ -1566,10 +1622,10 @@ void DebugReader::handleRegisterNames(const QList<GDBMIResultParser::ParseValue>
     emit registerNamesUpdated(nameList);
 }
 
-void DebugReader::handleRegisterValue(const QList<GDBMIResultParser::ParseValue> &values)
+void DebugReader::handleRegisterValue(const GDBMIResultParser::ParseArray &values)
 {
     QHash<int,QString> result;
-    foreach (const GDBMIResultParser::ParseValue& val, values) {
+    for (const GDBMIResultParser::ParseValue& val : values) {
         GDBMIResultParser::ParseObject obj = val.object();
         int number = obj["number"].intValue();
         QString value = obj["value"].value();
@@ -1603,10 +1659,10 @@ void DebugReader::handleListVarChildren(const GDBMIResultParser::ParseObject &mu
         return;
     QString parentName = mCurrentCmd->params;
     int parentNumChild = multiVars["numchild"].intValue(0);
-    QList<GDBMIResultParser::ParseValue> children = multiVars["children"].array();
+    GDBMIResultParser::ParseArray children = multiVars["children"].array();
     bool hasMore = multiVars["has_more"].value()!="0";
     emit prepareVarChildren(parentName,parentNumChild,hasMore);
-    foreach(const GDBMIResultParser::ParseValue& child, children) {
+    for (const GDBMIResultParser::ParseValue& child : children) {
         GDBMIResultParser::ParseObject childObj = child.object();
         QString name = childObj["name"].value();
         QString exp = childObj["exp"].value();
@@ -1624,9 +1680,9 @@ void DebugReader::handleListVarChildren(const GDBMIResultParser::ParseObject &mu
     }
 }
 
-void DebugReader::handleUpdateVarValue(const QList<GDBMIResultParser::ParseValue> &changes)
+void DebugReader::handleUpdateVarValue(const GDBMIResultParser::ParseArray &changes)
 {
-    foreach (const GDBMIResultParser::ParseValue& value, changes) {
+    for (const GDBMIResultParser::ParseValue& value : changes) {
         GDBMIResultParser::ParseObject obj = value.object();
         QString name = obj["name"].value();
         QString val = obj["value"].value();
@@ -1642,14 +1698,16 @@ void DebugReader::handleUpdateVarValue(const QList<GDBMIResultParser::ParseValue
     //emit varsValueUpdated();
 }
 
-QByteArray DebugReader::removeToken(const QByteArray &line)
+QByteArray DebugReader::removeToken(const QByteArray &line, int &token)
 {
     int p=0;
+    token=0;
     while (p<line.length()) {
         QChar ch=line[p];
         if (ch<'0' || ch>'9') {
             break;
         }
+        token = token*10 + (ch.unicode()-'0');
         p++;
     }
     if (p<line.length())
@@ -1744,11 +1802,17 @@ void DebugReader::setDebuggerPath(const QString &debuggerPath)
 void DebugReader::stopDebug()
 {
     mStop = true;
+    QMutexLocker locker(&mCmdQueueMutex);
+    if (mProcess)
+        QMetaObject::invokeMethod(mProcess.get(),[this]{
+            quit();
+        }, Qt::QueuedConnection);
 }
 
 bool DebugReader::commandRunning()
 {
-    return !mCmdQueue.isEmpty();
+    QMutexLocker locker(&mCmdQueueMutex);
+    return !mCmdQueue.isEmpty() || !mRunningCmds.isEmpty();
 }
 
 void DebugReader::waitStart()
@@ -1767,8 +1831,16 @@ void DebugReader::run()
     QString arguments = "--interpret=mi --silent";
     QString workingDir = QFileInfo(mDebuggerPath).path();
 
-    mProcess = std::make_shared<QProcess>();
+    {
+        QMutexLocker locker(&mCmdQueueMutex);
+        mProcess = std::make_shared<QProcess>();
+        mRunningCmds.clear();
+        mExclusiveCmdRunning = false;
+    }
+    mOutputBuffer.clear();
+    mOutputLines.clear();
     auto action = finally([&]{
+        QMutexLocker locker(&mCmdQueueMutex);
         mProcess.reset();
     });
     mProcess->setProgram(cmd);
@@ -1792,41 +1864,31 @@ void DebugReader::run()
 
     mProcess->setWorkingDirectory(workingDir);
 
+    //the process lives in this thread, so its signals are handled by the event loop below
     connect(mProcess.get(), &QProcess::errorOccurred,
                     [&](){
                         mErrorOccured= true;
+                        quit();
+                    });
+    connect(mProcess.get(), &QProcess::readyRead,
+                    [this](){
+                        readOutput();
+                    });
+    connect(mProcess.get(), QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                    [this](){
+                        quit();
                     });
-    QByteArray buffer;
-    QByteArray readed;
 
     mProcess->start();
     mProcess->waitForStarted(5000);
     mStartSemaphore.release(1);
-    while (true) {
-        mProcess->waitForFinished(1);
-        if (mProcess->state()!=QProcess::Running) {
-            break;
-        }
-        if (mStop) {
-            mProcess->terminate();
-            mProcess->kill();
-            break;
-        }
-        if (mErrorOccured)
-            break;
-        readed = mProcess->readAll();
-        buffer += readed;
-
-        if (readed.endsWith("\n")&& outputTerminated(buffer)) {
-            processDebugOutput(buffer);
-            buffer.clear();
-            mCmdRunning = false;
-            runNextCmd();
-        } else if (!mCmdRunning && readed.isEmpty()){
-            runNextCmd();
-        } else if (readed.isEmpty()){
-            msleep(1);
-        }
+    if (!mStop && !mErrorOccured && mProcess->state()==QProcess::Running) {
+        runNextCmd();
+        exec();
+    }
+    if (mStop) {
+        mProcess->terminate();
+        mProcess->kill();
     }
     if (mErrorOccured) {
         emit processError(mProcess->error());
@@ -48,6 +48,7 @@ struct DebugCommand{
     QString command;
     QString params;
     DebugCommandSource source;
+    int token; // MI token the command is sent with, its result record carries the same token
 };
 
 using PDebugCommand = std::shared_ptr<DebugCommand>;
@@ -552,28 +553,29 @@ private:
     void clearCmdQueue();
 
     void runNextCmd();
+    bool isExclusiveCmd(const PDebugCommand& cmd);
+    void readOutput();
     QStringList tokenize(const QString& s);
 
-    bool outputTerminated(const QByteArray& text);
     void handleBreakpoint(const GDBMIResultParser::ParseObject& breakpoint);
     void handleFrame(const GDBMIResultParser::ParseValue &frame);
-    void handleStack(const QList<GDBMIResultParser::ParseValue> & stack);
-    void handleLocalVariables(const QList<GDBMIResultParser::ParseValue> & variables);
+    void handleStack(const GDBMIResultParser::ParseArray & stack);
+    void handleLocalVariables(const GDBMIResultParser::ParseArray & variables);
     void handleEvaluation(const QString& value);
-    void handleMemory(const QList<GDBMIResultParser::ParseValue> & rows);
-    void handleRegisterNames(const QList<GDBMIResultParser::ParseValue> & names);
-    void handleRegisterValue(const QList<GDBMIResultParser::ParseValue> & values);
+    void handleMemory(const GDBMIResultParser::ParseArray & rows);
+    void handleRegisterNames(const GDBMIResultParser::ParseArray & names);
+    void handleRegisterValue(const GDBMIResultParser::ParseArray & values);
     void handleCreateVar(const GDBMIResultParser::ParseObject& multiVars);
     void handleListVarChildren(const GDBMIResultParser::ParseObject& multiVars);
-    void handleUpdateVarValue(const QList<GDBMIResultParser::ParseValue> &changes);
+    void handleUpdateVarValue(const GDBMIResultParser::ParseArray &changes);
     void processConsoleOutput(const QByteArray& line);
-    void processResult(const QByteArray& result);
+    void processResult(const QByteArray& line, int start);
     void processExecAsyncRecord(const QByteArray& line);
     void processError(const QByteArray& errorLine);
     void processResultRecord(const QByteArray& line);
-    void processDebugOutput(const QByteArray& debugOutput);
+    void processDebugOutput(const QList<QByteArray>& lines);
     void runInferiorStoppedHook();
-    QByteArray removeToken(const QByteArray& line);
+    QByteArray removeToken(const QByteArray& line, int& token);
 private slots:
     void asyncUpdate();
 private:
@@ -589,9 +591,15 @@ private:
     bool mErrorOccured;
     bool mAsyncUpdated;
     //fOnInvalidateAllVars: TInvalidateAllVarsEvent;
-    bool mCmdRunning;
+    QMap<int,PDebugCommand> mRunningCmds; // commands sent to gdb and waiting for results, by token
+    int mNextToken;
+    bool mExclusiveCmdRunning;
+    //*stopped may come in a later output batch than the exec command that resumed the inferior
+    DebugCommandSource mLastExclusiveCmdSource;
     PDebugCommand mCurrentCmd;
     std::shared_ptr<QProcess> mProcess;
+    QByteArray mOutputBuffer; // incomplete output line
+    QList<QByteArray> mOutputLines; // output lines before the next "(gdb)" prompt
     QStringList mBinDirs;
 
     //fWatchView: TTreeView;
@@ -48,6 +48,7 @@
 #include <QTextDocument>
 #include <QTextCodec>
 #include <QScrollBar>
+#include <QElapsedTimer>
 #include "iconsmanager.h"
 #include "debugger.h"
 #include "editorlist.h"
@@ -57,6 +58,13 @@
 
 QHash<ParserLanguage,std::weak_ptr<CppParser>> Editor::mSharedParsers;
 
+//max time (in ms) spent in resolving identifiers in one round of the background timer
+#define SEMANTIC_TOKENS_TIME_SLICE 20
+//lines around the window resolved in the background for large files, which are loaded lazily
+#define SEMANTIC_TOKENS_LARGE_FILE_MARGIN 500
+//line edits kept for reparsing function bodies; older ones force a full parse
+#define MAX_LINE_EDITS 1000
+
 Editor::Editor(QWidget *parent):
     Editor(parent,"untitled",ENCODING_AUTO_DETECT,nullptr,true,nullptr)
 {
@@ -88,6 +96,11 @@ Editor::Editor(QWidget *parent, const QString& filename,
     mHighlightCharPos1 = QSynedit::BufferCoord{0,0};
     mHighlightCharPos2 = QSynedit::BufferCoord{0,0};
     mCurrentLineModified = false;
+    mSemanticTokensResumeLine = 0;
+    mSemanticTokensStartLine = 0;
+    mEditRevision = 0;
+    mParsedRevision = 0;
+    mLineEditsDroppedRevision = 0;
     mUseCppSyntax = pSettings->editor().defaultFileCpp();
     if (mFilename.isEmpty()) {
         mFilename = QString("untitled%1").arg(getNewFileNumber());
@@ -155,6 +168,16 @@ Editor::Editor(QWidget *parent, const QString& filename,
             this, &Editor::onLinesDeleted);
     connect(this,&QSynEdit::linesInserted,
             this, &Editor::onLinesInserted);
+    connect(document().get(), &QSynedit::Document::inserted,
+            this, &Editor::onDocumentLinesInserted);
+    connect(document().get(), &QSynedit::Document::deleted,
+            this, &Editor::onDocumentLinesDeleted);
+    connect(document().get(), &QSynedit::Document::putted,
+            this, &Editor::onDocumentLinesPutted);
+    mSemanticTokensTimer.setSingleShot(true);
+    mSemanticTokensTimer.setInterval(0);
+    connect(&mSemanticTokensTimer, &QTimer::timeout,
+            this, &Editor::onSemanticTokensTimer);
 
     setContextMenuPolicy(Qt::CustomContextMenu);
 
@@ -1137,31 +1160,21 @@ void Editor::onPreparePaintHighlightToken(int line, int aChar, const QString &to
                 }
             }
         } else if (mParser->enabled() && attr->tokenType() == QSynedit::TokenType::Identifier) {
-            QSynedit::BufferCoord p{aChar,line};
-    //        BufferCoord pBeginPos,pEndPos;
-    //        QString s= getWordAtPosition(this,p, pBeginPos,pEndPos, WordPurpose::wpInformation);
-    //        qDebug()<<s;
-    //        PStatement statement = mParser->findStatementOf(mFilename,
-    //          s , p.Line);
-            StatementKind kind;
-            if (mParser->parsing()){
-                kind=mIdentCache.value(QString("%1 %2").arg(aChar).arg(token),StatementKind::skUnknown);
+            StatementKind kind = StatementKind::skUnknown;
+            PLineStatementKinds lineKinds;
+            if (line-1 < mSemanticTokens.count())
+                lineKinds = mSemanticTokens[line-1];
+            if (lineKinds) {
+                kind = lineKinds->value(aChar,StatementKind::skUnknown);
             } else {
-                QStringList expression = getExpressionAtPosition(p);
-                PStatement statement = parser()->findStatementOf(
-                            filename(),
-                            expression,
-                            p.line);
-                kind = getKindOfStatement(statement);
-                mIdentCache.insert(QString("%1 %2").arg(aChar).arg(token),kind);
+                //not resolved yet, use the last known result and let the timer resolve it
+                kind=mIdentCache.value(QString("%1 %2").arg(aChar).arg(token),StatementKind::skUnknown);
+                if (!mSemanticTokensTimer.isActive())
+                    mSemanticTokensTimer.start();
             }
             if (kind == StatementKind::skUnknown) {
-                QSynedit::BufferCoord pBeginPos,pEndPos;
-                QString s= getWordAtPosition(this,p, pBeginPos,pEndPos, WordPurpose::wpInformation);
-                if ((pEndPos.line>=1)
-                  && (pEndPos.ch>=0)
-                  && (pEndPos.ch+1 < document()->getLine(pEndPos.line-1).length())
-                  && (document()->getLine(pEndPos.line-1)[pEndPos.ch+1] == '(')) {
+                int pos = aChar - 1 + token.length();
+                if (pos < lineText.length() && lineText[pos] == '(') {
                     kind = StatementKind::skFunction;
                 } else {
                     kind = StatementKind::skVariable;
@@ -1384,6 +1397,8 @@ void Editor::showEvent(QShowEvent */*event*/)
                 &Editor::onEndParsing);
         reparse(false);
     }
+    //the parser may have been changed by other editors while we are hidden
+    resetSemanticTokens();
     if (mParentPageControl) {
         pMainWindow->debugger()->setIsForProject(inProject());
         pMainWindow->bookmarkModel()->setIsForProject(inProject());
@@ -2076,11 +2091,213 @@ void Editor::onTooltipTimer()
 
 void Editor::onEndParsing()
 {
-
     mIdentCache.clear();
+    resetSemanticTokens();
     invalidate();
 }
 
+void Editor::resetSemanticTokens()
+{
+    mSemanticTokens.fill(PLineStatementKinds(),document()->count());
+    mSemanticTokensResumeLine = 0;
+    //resolve the visible lines now to avoid flicking, and the rest in the background
+    onSemanticTokensTimer();
+}
+
+void Editor::onSemanticTokensTimer()
+{
+    if (!mParser || !mParser->enabled() || mParser->parsing() || !syntaxer())
+        return;
+    if (!isVisible())
+        return;
+    if (mSemanticTokens.count() != document()->count()) {
+        mSemanticTokens.fill(PLineStatementKinds(),document()->count());
+        mSemanticTokensResumeLine = 0;
+    }
+    if (mSemanticTokens.isEmpty())
+        return;
+    QSynedit::CppSyntaxer cppSyntaxer;
+    //visible lines first
+    int firstLine = std::max(rowToLine(topLine()),1) - 1;
+    int lastLine = std::min(rowToLine(topLine()+linesInWindow()), mSemanticTokens.count()) - 1;
+    for (int i=firstLine;i<=lastLine;i++) {
+        if (!mSemanticTokens[i]) {
+            mSemanticTokens[i] = resolveLineStatementKinds(cppSyntaxer, i);
+            invalidateLine(i+1);
+        }
+    }
+    //then the rest of the file, or only the lines near the window for large files
+    int startLine = 0;
+    int endLine = mSemanticTokens.count();
+    if (document()->largeFile()) {
+        startLine = std::max(firstLine - SEMANTIC_TOKENS_LARGE_FILE_MARGIN, 0);
+        endLine = std::min(lastLine + 1 + SEMANTIC_TOKENS_LARGE_FILE_MARGIN, endLine);
+        if (startLine != mSemanticTokensStartLine)
+            mSemanticTokensResumeLine = startLine;
+        mSemanticTokensStartLine = startLine;
+    }
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+    for (int i=std::max(mSemanticTokensResumeLine, startLine);i<endLine;i++) {
+        if (!mSemanticTokens[i]) {
+            if (elapsedTimer.elapsed() >= SEMANTIC_TOKENS_TIME_SLICE) {
+                mSemanticTokensResumeLine = i;
+                mSemanticTokensTimer.start();
+                return;
+            }
+            mSemanticTokens[i] = resolveLineStatementKinds(cppSyntaxer, i);
+        }
+    }
+    mSemanticTokensResumeLine = endLine;
+}
+
+void Editor::onDocumentLinesInserted(int index, int count)
+{
+    if (index <= mSemanticTokens.count())
+        mSemanticTokens.insert(index, count, PLineStatementKinds());
+    mSemanticTokensResumeLine = std::min(mSemanticTokensResumeLine, index);
+    addLineEdit(LineEditKind::Inserted, index, count);
+}
+
+void Editor::onDocumentLinesDeleted(int index, int count)
+{
+    if (index < mSemanticTokens.count())
+        mSemanticTokens.remove(index, std::min(count, mSemanticTokens.count()-index));
+    mSemanticTokensResumeLine = std::min(mSemanticTokensResumeLine, index);
+    addLineEdit(LineEditKind::Deleted, index, count);
+}
+
+void Editor::onDocumentLinesPutted(int index, int count)
+{
+    for (int i=index;i<index+count && i<mSemanticTokens.count();i++)
+        mSemanticTokens[i].reset();
+    mSemanticTokensResumeLine = std::min(mSemanticTokensResumeLine, index);
+    addLineEdit(LineEditKind::Putted, index, count);
+}
+
+//called with the document locked, so the revision always matches the contents
+void Editor::addLineEdit(LineEditKind kind, int index, int count)
+{
+    int revision = mEditRevision.fetchAndAddOrdered(1)+1;
+    if (mLineEdits.count()>=MAX_LINE_EDITS) {
+        mLineEdits.clear();
+        mLineEditsDroppedRevision = revision;
+        return;
+    }
+    mLineEdits.append(LineEdit{revision, kind, index, count});
+}
+
+static void addEditedLines(int& firstLine, int& lastLine, int& lineDelta, int first, int last, int delta)
+{
+    if (firstLine<0) {
+        firstLine = first;
+        lastLine = last;
+    } else {
+        firstLine = std::min(firstLine, first);
+        lastLine = std::max(lastLine, last);
+    }
+    lineDelta += delta;
+}
+
+//Merge the edits made after the parser last read the contents.
+//firstLine is -1 if nothing is edited, or if the edits are unknown.
+void Editor::takeEditedLines(int &firstLine, int &lastLine, int &lineDelta)
+{
+    firstLine = -1;
+    lastLine = -1;
+    lineDelta = 0;
+    int parsedRevision = mParsedRevision.loadAcquire();
+    int i=0;
+    while (i<mLineEdits.count() && mLineEdits[i].revision<=parsedRevision)
+        i++;
+    mLineEdits.remove(0,i);
+    if (mLineEditsDroppedRevision>parsedRevision)
+        return;
+    foreach (const LineEdit& edit, mLineEdits) {
+        int index = edit.index;
+        int count = edit.count;
+        switch(edit.kind) {
+        case LineEditKind::Inserted:
+            if (firstLine>index)
+                firstLine += count;
+            if (lastLine>index)
+                lastLine += count;
+            addEditedLines(firstLine, lastLine, lineDelta, index+1, index+count, count);
+            break;
+        case LineEditKind::Deleted:
+            if (firstLine>index+count)
+                firstLine -= count;
+            else if (firstLine>index)
+                firstLine = index+1;
+            if (lastLine>index+count)
+                lastLine -= count;
+            else if (lastLine>index)
+                lastLine = index+1;
+            addEditedLines(firstLine, lastLine, lineDelta, index+1, index+1, -count);
+            break;
+        case LineEditKind::Putted:
+            addEditedLines(firstLine, lastLine, lineDelta, index+1, index+count, 0);
+            break;
+        }
+    }
+}
+
+QStringList Editor::contentsForParser(const CppParser *parser)
+{
+    //edits are made with the document locked, so retry if one is made while copying
+    int revision;
+    QStringList result;
+    do {
+        revision = mEditRevision.loadAcquire();
+        result = contents();
+    } while (revision != mEditRevision.loadAcquire());
+    if (parser == mParser.get() && revision > mParsedRevision.loadAcquire())
+        mParsedRevision.storeRelease(revision);
+    return result;
+}
+
+PLineStatementKinds Editor::resolveLineStatementKinds(QSynedit::CppSyntaxer &cppSyntaxer, int line)
+{
+    PLineStatementKinds result = std::make_shared<QHash<int,StatementKind>>();
+    QString lineText = document()->getLine(line);
+    if (mParser->isIncludeLine(lineText))
+        return result;
+    if (line==0) {
+        cppSyntaxer.resetState();
+    } else {
+        cppSyntaxer.setState(document()->getSyntaxState(line-1));
+    }
+    cppSyntaxer.setLine(lineText, line);
+    while (!cppSyntaxer.eol()) {
+        if (cppSyntaxer.getTokenAttribute()->tokenType() == QSynedit::TokenType::Identifier) {
+            int aChar = cppSyntaxer.getTokenPos()+1;
+            QSynedit::BufferCoord p{aChar,line+1};
+            QStringList expression = getExpressionAtPosition(p);
+            PStatement statement = mParser->findStatementOf(
+                        filename(),
+                        expression,
+                        p.line);
+            StatementKind kind = getKindOfStatement(statement);
+            mIdentCache.insert(QString("%1 %2").arg(aChar).arg(cppSyntaxer.getToken()),kind);
+            if (kind == StatementKind::skUnknown) {
+                QSynedit::BufferCoord pBeginPos,pEndPos;
+                getWordAtPosition(this,p, pBeginPos,pEndPos, WordPurpose::wpInformation);
+                if ((pEndPos.line>=1)
+                  && (pEndPos.ch>=0)
+                  && (pEndPos.ch+1 < document()->getLine(pEndPos.line-1).length())
+                  && (document()->getLine(pEndPos.line-1)[pEndPos.ch+1] == '(')) {
+                    kind = StatementKind::skFunction;
+                } else {
+                    kind = StatementKind::skVariable;
+                }
+            }
+            result->insert(aChar,kind);
+        }
+        cppSyntaxer.next();
+    }
+    return result;
+}
+
 void Editor::resolveAutoDetectEncodingOption()
 {
     if (mEncodingOption==ENCODING_AUTO_DETECT) {
@@ -2904,8 +3121,8 @@ void Editor::initParser()
             }
             mParser->setOnGetFileStream(
                         std::bind(
-                            &EditorList::getContentFromOpenedEditor,pMainWindow->editorList(),
-                            std::placeholders::_1, std::placeholders::_2));
+                            &EditorList::getContentForParser,pMainWindow->editorList(),
+                            mParser.get(), std::placeholders::_1, std::placeholders::_2));
             resetCppParser(mParser);
             mParser->setEnabled(
                         pSettings->codeCompletion().enabled() &&
@@ -3057,6 +3274,7 @@ void Editor::reparse(bool resetParser)
 
     //mParser->setEnabled(pSettings->codeCompletion().enabled());
     ParserLanguage language = mUseCppSyntax?ParserLanguage::CPlusPlus:ParserLanguage::C;
+    bool fullParse = resetParser || language!=mParser->language();
     if (!inProject()) {
         if (pSettings->codeCompletion().shareParser()) {
             if (language!=mParser->language()) {
@@ -3072,6 +3290,15 @@ void Editor::reparse(bool resetParser)
             }
         }
     }
+    //the edits are only taken as parsed when the parser reads the contents
+    int firstLine, lastLine, lineDelta;
+    takeEditedLines(firstLine, lastLine, lineDelta);
+    //typing inside a function body only changes its local statements
+    if (!fullParse && firstLine>0
+            && mParser->parseFunctionBody(mFilename, firstLine, lastLine, lineDelta)) {
+        mParsedRevision.storeRelease(mEditRevision.loadAcquire());
+        return;
+    }
     parseFile(mParser,mFilename, inProject());
 }
 
@@ -3616,9 +3843,9 @@ void Editor::completionInsert(bool appendFunc)
 
     if (pSettings->codeCompletion().recordUsage()
             && statement->kind != StatementKind::skUserCodeSnippet) {
-        statement->usageCount+=1;
+        PSymbolUsage usage = pMainWindow->symbolUsageManager()->findUsage(statement->fullName);
         pMainWindow->symbolUsageManager()->updateUsage(statement->fullName,
-                                                         statement->usageCount);
+                                                         usage?usage->count+1:1);
     }
 
     QString funcAddOn = "";
@@ -4379,6 +4606,8 @@ void Editor::onExportedFormatToken(QSynedit::PSyntaxer syntaxer, int Line, int c
 void Editor::onScrollBarValueChanged()
 {
     pMainWindow->functionTip()->hide();
+    if (!mSemanticTokensTimer.isActive())
+        mSemanticTokensTimer.start();
 }
 
 PCppParser Editor::sharedParser(ParserLanguage language)
@@ -4392,8 +4621,8 @@ PCppParser Editor::sharedParser(ParserLanguage language)
         parser->setLanguage(language);
         parser->setOnGetFileStream(
                     std::bind(
-                        &EditorList::getContentFromOpenedEditor,pMainWindow->editorList(),
-                        std::placeholders::_1, std::placeholders::_2));
+                        &EditorList::getContentForParser,pMainWindow->editorList(),
+                        parser.get(), std::placeholders::_1, std::placeholders::_2));
         resetCppParser(parser);
         parser->setEnabled(true);
         mSharedParsers.insert(language,parser);
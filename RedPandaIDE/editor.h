@@ -40,9 +40,15 @@ struct TabStop {
 };
 
 class QTemporaryFile;
+namespace QSynedit {
+class CppSyntaxer;
+}
 
 using PTabStop = std::shared_ptr<TabStop>;
 
+// statement kinds of the identifiers in a line, keyed by their start char
+using PLineStatementKinds = std::shared_ptr<QHash<int,StatementKind>>;
+
 class Editor : public QSynedit::QSynEdit
 {
     Q_OBJECT
@@ -222,6 +228,9 @@ public:
     void resetBookmarks();
 
     const PCppParser &parser() const;
+    // contents read by the parser; the edits before them are no longer pending for it.
+    // may be called in the parser's thread
+    QStringList contentsForParser(const CppParser* parser);
 
     void tab() override;
 
@@ -240,8 +249,25 @@ private slots:
     void onAutoBackupTimer();
     void onTooltipTimer();
     void onEndParsing();
+    void onSemanticTokensTimer();
+    void onDocumentLinesInserted(int index, int count);
+    void onDocumentLinesDeleted(int index, int count);
+    void onDocumentLinesPutted(int index, int count);
 
 private:
+    enum class LineEditKind {
+        Inserted,
+        Deleted,
+        Putted
+    };
+    struct LineEdit {
+        int revision;
+        LineEditKind kind;
+        int index;
+        int count;
+    };
+    void addLineEdit(LineEditKind kind, int index, int count);
+    void takeEditedLines(int& firstLine, int& lastLine, int& lineDelta);
     void resolveAutoDetectEncodingOption();
     bool isBraceChar(QChar ch);
     bool shouldOpenInReadonly();
@@ -296,6 +322,8 @@ private:
     void onExportedFormatToken(QSynedit::PSyntaxer syntaxer, int Line, int column, const QString& token,
         QSynedit::PTokenAttribute &attr);
     void onScrollBarValueChanged();
+    void resetSemanticTokens();
+    PLineStatementKinds resolveLineStatementKinds(QSynedit::CppSyntaxer& cppSyntaxer, int line);
 private:
     bool mInited;
     QDateTime mBackupTime;
@@ -335,6 +363,11 @@ private:
 
     bool mSaving;
     bool mCurrentLineModified;
+    //line edits the parser has not read yet, in the order they are made
+    QVector<LineEdit> mLineEdits;
+    QAtomicInt mEditRevision;
+    QAtomicInt mParsedRevision; // revision of the contents last read by the parser
+    int mLineEditsDroppedRevision;
     int mXOffsetSince;
     int mTabStopBegin;
     int mTabStopEnd;
@@ -352,6 +385,10 @@ private:
     int mHoverModifiedLine;
     int mWheelAccumulatedDelta;
     QMap<QString,StatementKind> mIdentCache;
+    QVector<PLineStatementKinds> mSemanticTokens; // indexed by line (0-based), null if not resolved
+    int mSemanticTokensResumeLine; // lines before it are resolved by the background pass
+    int mSemanticTokensStartLine; // first line of the background pass for large files
+    QTimer mSemanticTokensTimer;
 
     static QHash<ParserLanguage,std::weak_ptr<CppParser>> mSharedParsers;
 
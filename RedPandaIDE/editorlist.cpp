@@ -427,6 +427,17 @@ bool EditorList::getContentFromOpenedEditor(const QString &filename, QStringList
     return true;
 }
 
+bool EditorList::getContentForParser(const CppParser *parser, const QString &filename, QStringList &buffer)
+{
+    if (pMainWindow->isQuitting())
+        return false;
+    Editor * e= getOpenedEditorByFilename(filename);
+    if (!e)
+        return false;
+    buffer = e->contentsForParser(parser);
+    return true;
+}
+
 void EditorList::getVisibleEditors(Editor *&left, Editor *&right)
 {
     switch(mLayout) {
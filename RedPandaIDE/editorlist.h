@@ -24,6 +24,7 @@
 
 class Project;
 class Editor;
+class CppParser;
 class EditorList : public QObject
 {
     Q_OBJECT
@@ -62,6 +63,7 @@ public:
     Editor* getOpenedEditorByFilename(QString filename);
 
     bool getContentFromOpenedEditor(const QString& filename, QStringList& buffer);
+    bool getContentForParser(const CppParser* parser, const QString& filename, QStringList& buffer);
 
     void getVisibleEditors(Editor*& left, Editor*& right);
     void updateLayout();
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "filesearcher.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QTextCodec>
+#include <QThreadPool>
+#include <qsynedit/searcher/basicsearcher.h>
+#include <qsynedit/searcher/regexsearcher.h>
+#include <qt_utils/charsetinfo.h>
+#include "utils.h"
+
+//min interval (in milliseconds) between two result updates
+#define RESULTS_UPDATE_INTERVAL 100
+
+class FileSearchTask: public QRunnable {
+public:
+    explicit FileSearchTask(FileSearcher* searcher, int index):
+        mSearcher(searcher),
+        mIndex(index) {
+        setAutoDelete(false);
+    }
+    void run() override {
+        if (!mSearcher->mStop.loadAcquire())
+            mResult = mSearcher->searchFile(mSearcher->mFiles[mIndex]);
+        mDone.release();
+    }
+    void waitForDone() {
+        mDone.acquire();
+    }
+    const PSearchResultTreeItem& result() const {
+        return mResult;
+    }
+private:
+    FileSearcher* mSearcher;
+    int mIndex;
+    PSearchResultTreeItem mResult;
+    QSemaphore mDone;
+};
+
+FileSearcher::FileSearcher(const QString &keyword, QSynedit::SearchOptions options, QObject *parent):
+    QThread(parent),
+    mKeyword(keyword),
+    mOptions(options),
+    mStop(0)
+{
+    bool isAscii = !keyword.isEmpty();
+    foreach (const QChar& ch, keyword) {
+        if (ch.unicode()>=128) {
+            isAscii = false;
+            break;
+        }
+    }
+    if (isAscii && !options.testFlag(QSynedit::ssoRegExp)) {
+        mAsciiKeyword = keyword.toLatin1();
+        if (options.testFlag(QSynedit::ssoMatchCase))
+            mKeywordMatcher.setPattern(mAsciiKeyword);
+        else
+            mAsciiKeyword = mAsciiKeyword.toLower();
+    }
+}
+
+void FileSearcher::addFile(const QString &filename, const QStringList &contents)
+{
+    SearchFile file;
+    file.filename = filename;
+    file.contents = contents;
+    file.opened = true;
+    mFiles.append(file);
+}
+
+void FileSearcher::addFile(const QString &filename, const QByteArray &encoding)
+{
+    SearchFile file;
+    file.filename = filename;
+    file.encoding = encoding;
+    file.opened = false;
+    mFiles.append(file);
+}
+
+int FileSearcher::fileCount() const
+{
+    return mFiles.count();
+}
+
+void FileSearcher::stop()
+{
+    mStop.storeRelease(1);
+}
+
+PSearchResultTreeItem FileSearcher::searchFile(const SearchFile &file)
+{
+    QStringList lines;
+    if (file.opened) {
+        lines = file.contents;
+    } else {
+        QFile f(file.filename);
+        if (!f.open(QFile::ReadOnly))
+            return PSearchResultTreeItem();
+        QByteArray content = f.readAll();
+        if (!mayContainKeyword(content, file.encoding))
+            return PSearchResultTreeItem();
+        lines = decodeLines(content, file.encoding);
+    }
+    QSynedit::PSynSearchBase searchEngine;
+    if (mOptions.testFlag(QSynedit::ssoRegExp)) {
+        searchEngine = std::make_shared<QSynedit::RegexSearcher>();
+    } else {
+        searchEngine = std::make_shared<QSynedit::BasicSearcher>();
+    }
+    searchEngine->setOptions(mOptions);
+    searchEngine->setPattern(mKeyword);
+
+    PSearchResultTreeItem parentItem;
+    for (int i=0;i<lines.count();i++) {
+        const QString& line = lines[i];
+        int n = searchEngine->findAll(line);
+        if (n==0)
+            continue;
+        if (!parentItem) {
+            parentItem = std::make_shared<SearchResultTreeItem>();
+            parentItem->filename = file.filename;
+            parentItem->parent = nullptr;
+        }
+        QString text = line;
+        text.replace('\t',' ');
+        for (int j=0;j<n;j++) {
+            PSearchResultTreeItem item = std::make_shared<SearchResultTreeItem>();
+            item->filename = file.filename;
+            item->line = i+1;
+            item->start = searchEngine->result(j)+1;
+            item->len = searchEngine->length(j);
+            item->parent = parentItem.get();
+            item->text = text;
+            parentItem->results.append(item);
+        }
+    }
+    return parentItem;
+}
+
+bool FileSearcher::mayContainKeyword(const QByteArray &content, const QByteArray &encoding) const
+{
+    if (mAsciiKeyword.isEmpty())
+        return true;
+    //utf-16/utf-32 files don't store ascii chars as single bytes
+    if (encoding.startsWith("UTF-16") || encoding.startsWith("UTF-32"))
+        return true;
+    if (content.startsWith("\xFF\xFE") || content.startsWith("\xFE\xFF"))
+        return true;
+    if (mOptions.testFlag(QSynedit::ssoMatchCase))
+        return mKeywordMatcher.indexIn(content)>=0;
+    const char* p = content.constData();
+    const char* end = p + content.length() - mAsciiKeyword.length();
+    char first = mAsciiKeyword[0];
+    char upperFirst = QChar::toUpper((uchar)first);
+    for (;p<=end;p++) {
+        if ((*p==first || *p==upperFirst)
+                && qstrnicmp(p, mAsciiKeyword.constData(), mAsciiKeyword.length())==0)
+            return true;
+    }
+    return false;
+}
+
+QStringList FileSearcher::decodeLines(const QByteArray &content, const QByteArray &encoding) const
+{
+    //same rules as QSynedit::Document::loadFromFile()
+    QTextCodec* codec = nullptr;
+    QString text;
+    if (content.startsWith("\xEF\xBB\xBF")) {
+        codec = QTextCodec::codecForName(ENCODING_UTF8);
+        text = codec->toUnicode(content.constData()+3, content.length()-3);
+    } else if (content.startsWith(QByteArray("\xFF\xFE\x00\x00",4))) {
+        codec = QTextCodec::codecForName(ENCODING_UTF32);
+        text = codec->toUnicode(content);
+    } else if (content.startsWith("\xFF\xFE")) {
+        codec = QTextCodec::codecForName(ENCODING_UTF16);
+        text = codec->toUnicode(content);
+    } else if (encoding == ENCODING_AUTO_DETECT) {
+        QTextCodec::ConverterState state;
+        codec = QTextCodec::codecForName(ENCODING_UTF8);
+        text = codec->toUnicode(content.constData(),content.length(),&state);
+        if (state.invalidChars>0) {
+            codec = QTextCodec::codecForName(pCharsetInfoManager->getDefaultSystemEncoding());
+            if (codec)
+                text = codec->toUnicode(content);
+        }
+    } else {
+        QByteArray realEncoding = encoding;
+        if (realEncoding == ENCODING_SYSTEM_DEFAULT)
+            realEncoding = pCharsetInfoManager->getDefaultSystemEncoding();
+        else if (realEncoding == ENCODING_UTF8_BOM)
+            realEncoding = ENCODING_UTF8;
+        else if (realEncoding == ENCODING_UTF16_BOM)
+            realEncoding = ENCODING_UTF16;
+        else if (realEncoding == ENCODING_UTF32_BOM)
+            realEncoding = ENCODING_UTF32;
+        codec = QTextCodec::codecForName(realEncoding);
+        if (!codec)
+            codec = QTextCodec::codecForName(ENCODING_UTF8);
+        text = codec->toUnicode(content);
+    }
+    QStringList lines;
+    const QChar* p = text.constData();
+    const QChar* end = p + text.length();
+    const QChar* lineStart = p;
+    while (p<end) {
+        if (*p=='\r' || *p=='\n') {
+            lines.append(QString(lineStart,p-lineStart));
+            if (*p=='\r' && p+1<end && *(p+1)=='\n')
+                p++;
+            p++;
+            lineStart = p;
+        } else {
+            p++;
+        }
+    }
+    if (lineStart<end)
+        lines.append(QString(lineStart,end-lineStart));
+    return lines;
+}
+
+void FileSearcher::run()
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1,QThread::idealThreadCount()));
+    QVector<std::shared_ptr<FileSearchTask>> tasks;
+    for (int i=0;i<mFiles.count();i++) {
+        std::shared_ptr<FileSearchTask> task = std::make_shared<FileSearchTask>(this,i);
+        tasks.append(task);
+        pool.start(task.get());
+    }
+    QElapsedTimer timer;
+    timer.start();
+    PSearchResultTreeItemList items = std::make_shared<SearchResultTreeItemList>();
+    for (int i=0;i<tasks.count();i++) {
+        if (mStop.loadAcquire())
+            break;
+        std::shared_ptr<FileSearchTask> task = tasks[i];
+        //not started yet, run it here instead of waiting
+        if (pool.tryTake(task.get()))
+            task->run();
+        task->waitForDone();
+        if (task->result())
+            items->append(task->result());
+        if (timer.elapsed()>=RESULTS_UPDATE_INTERVAL || i==tasks.count()-1) {
+            if (!items->isEmpty()) {
+                emit resultsFound(items);
+                items = std::make_shared<SearchResultTreeItemList>();
+            }
+            emit progress(i+1,tasks.count());
+            timer.restart();
+        }
+    }
+    //tasks are owned here, so wait for the running ones before releasing them
+    pool.clear();
+    pool.waitForDone();
+}
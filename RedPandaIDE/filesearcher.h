@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILESEARCHER_H
+#define FILESEARCHER_H
+
+#include <QThread>
+#include <QByteArrayMatcher>
+#include "widgets/searchresultview.h"
+
+class FileSearchTask;
+
+//Searches files in the thread pool, without loading them into editors.
+class FileSearcher : public QThread
+{
+    Q_OBJECT
+public:
+    explicit FileSearcher(const QString& keyword, QSynedit::SearchOptions options, QObject* parent = nullptr);
+    //search the contents of an opened editor
+    void addFile(const QString& filename, const QStringList& contents);
+    //search the file on disk
+    void addFile(const QString& filename, const QByteArray& encoding);
+    int fileCount() const;
+public slots:
+    void stop();
+signals:
+    //files having matches, in the order they were added
+    void resultsFound(PSearchResultTreeItemList items);
+    void progress(int searched, int total);
+private:
+    struct SearchFile {
+        QString filename;
+        QByteArray encoding;
+        QStringList contents;
+        bool opened;
+    };
+    PSearchResultTreeItem searchFile(const SearchFile& file);
+    bool mayContainKeyword(const QByteArray& content, const QByteArray& encoding) const;
+    QStringList decodeLines(const QByteArray& content, const QByteArray& encoding) const;
+private:
+    QString mKeyword;
+    QSynedit::SearchOptions mOptions;
+    QList<SearchFile> mFiles;
+    QAtomicInt mStop;
+    //used to skip files not containing the keyword before decoding them
+    QByteArray mAsciiKeyword;
+    QByteArrayMatcher mKeywordMatcher;
+    friend class FileSearchTask;
+
+    // QThread interface
+protected:
+    void run() override;
+};
+
+#endif // FILESEARCHER_H
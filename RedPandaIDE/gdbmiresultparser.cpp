@@ -19,6 +19,7 @@
 #include <QFileInfo>
 #include <QList>
 #include <QDebug>
+#include <cstring>
 
 GDBMIResultParser::GDBMIResultParser()
 {
@@ -40,10 +41,15 @@ GDBMIResultParser::GDBMIResultParser()
     mResultTypes.insert("-stack-info-frame",GDBMIResultType::Frame);
 }
 
-bool GDBMIResultParser::parse(const QByteArray &record, const QString& command, GDBMIResultType &type, ParseObject& multiValues)
+bool GDBMIResultParser::parse(const QByteArray &record, int start, const QString& command, GDBMIResultType &type, ParseTree& tree)
 {
-    const char* p = record.data();
-    bool result = parseMultiValues(p,multiValues);
+    tree.clear();
+    tree.mRecord = record;
+    //rough guess of one node per 16 bytes, to avoid regrowing the array
+    tree.mNodes.reserve((record.length()-start)/16+1);
+    int root = newNode(tree, ParseValueType::Object);
+    const char* p = record.constData()+start;
+    bool result = parseMultiValues(p,tree,root);
     if (!result)
         return false;
 //    if (*p!=0)
@@ -54,9 +60,12 @@ bool GDBMIResultParser::parse(const QByteArray &record, const QString& command,
     return true;
 }
 
-bool GDBMIResultParser::parseAsyncResult(const QByteArray &record, QByteArray &result, ParseObject &multiValue)
+bool GDBMIResultParser::parseAsyncResult(const QByteArray &record, QByteArray &result, ParseTree& tree)
 {
-    const char* p =record.data();
+    tree.clear();
+    tree.mRecord = record;
+    int root = newNode(tree, ParseValueType::Object);
+    const char* p =record.constData();
     if (*p!='*')
         return false;
     p++;
@@ -67,17 +76,43 @@ bool GDBMIResultParser::parseAsyncResult(const QByteArray &record, QByteArray &r
     if (*p==0)
         return true;
     p++;
-    return parseMultiValues(p,multiValue);
+    return parseMultiValues(p,tree,root);
 }
 
-bool GDBMIResultParser::parseMultiValues(const char* p, ParseObject &multiValue)
+int GDBMIResultParser::newNode(ParseTree &tree, ParseValueType type)
 {
+    ParseNode node;
+    node.type = type;
+    node.escaped = false;
+    node.nameStart = 0;
+    node.nameLength = 0;
+    node.valueStart = 0;
+    node.valueLength = 0;
+    node.firstChild = -1;
+    node.childCount = 0;
+    node.nextSibling = -1;
+    tree.mNodes.append(node);
+    return tree.mNodes.length()-1;
+}
+
+void GDBMIResultParser::appendChild(ParseTree &tree, int parent, int &lastChild, int child)
+{
+    if (lastChild<0)
+        tree.mNodes[parent].firstChild = child;
+    else
+        tree.mNodes[lastChild].nextSibling = child;
+    tree.mNodes[parent].childCount++;
+    lastChild = child;
+}
+
+bool GDBMIResultParser::parseMultiValues(const char* p, ParseTree& tree, int parent)
+{
+    int lastChild = -1;
     while (*p) {
-        QByteArray propName;
-        ParseValue propValue;
-        bool result = parseNameAndValue(p,propName,propValue);
+        int node;
+        bool result = parseNameAndValue(p,tree,node);
         if (result) {
-            multiValue[propName]=propValue;
+            appendChild(tree,parent,lastChild,node);
         } else {
             return false;
         }
@@ -92,7 +127,7 @@ bool GDBMIResultParser::parseMultiValues(const char* p, ParseObject &multiValue)
     return true;
 }
 
-bool GDBMIResultParser::parseNameAndValue(const char *&p, QByteArray &name, ParseValue &value)
+bool GDBMIResultParser::parseNameAndValue(const char *&p, ParseTree& tree, int& node)
 {
     skipSpaces(p);
     const char* nameStart =p;
@@ -101,37 +136,36 @@ bool GDBMIResultParser::parseNameAndValue(const char *&p, QByteArray &name, Pars
     }
     if (*p==0)
         return false;
-    name = QByteArray(nameStart,p-nameStart);
+    const char* nameEnd = p;
     skipSpaces(p);
     if (*p!='=')
         return false;
     p++;
-    return parseValue(p,value);
+    if (!parseValue(p,tree,node))
+        return false;
+    ParseNode& parsed = tree.mNodes[node];
+    parsed.nameStart = nameStart - tree.mRecord.constData();
+    parsed.nameLength = nameEnd - nameStart;
+    return true;
 }
 
-bool GDBMIResultParser::parseValue(const char *&p, ParseValue &value)
+bool GDBMIResultParser::parseValue(const char *&p, ParseTree& tree, int& node)
 {
     skipSpaces(p);
     bool result;
     switch (*p) {
-    case '{': {
-        ParseObject obj;
-        result = parseObject(p,obj);
-        value = obj;
+    case '{':
+        node = newNode(tree,ParseValueType::Object);
+        result = parseObject(p,tree,node);
         break;
-    }
-    case '[': {
-        QList<ParseValue> array;
-        result = parseArray(p,array);
-        value = array;
+    case '[':
+        node = newNode(tree,ParseValueType::Array);
+        result = parseArray(p,tree,node);
         break;
-    }
-    case '"': {
-        QByteArray s;
-        result = parseStringValue(p,s);
-        value = s;
+    case '"':
+        node = newNode(tree,ParseValueType::Value);
+        result = parseStringValue(p,tree,node);
         break;
-    }
     default:
         return false;
     }
@@ -141,16 +175,42 @@ bool GDBMIResultParser::parseValue(const char *&p, ParseValue &value)
     return true;
 }
 
-bool GDBMIResultParser::parseStringValue(const char *&p, QByteArray& stringValue)
+bool GDBMIResultParser::parseStringValue(const char *&p, ParseTree& tree, int node)
 {
     if (*p!='"')
         return false;
     p++;
-    stringValue.clear();
+    const char* start = p;
+    bool escaped = false;
+    //only find the end of the string here; escapes are decoded by ParseValue::value()
     while (*p!=0) {
         if (*p == '"') {
             break;
         } else if (*p=='\\' && *(p+1)!=0) {
+            escaped = true;
+            p+=2;
+        } else {
+            p++;
+        }
+    }
+    if (*p=='"') {
+        ParseNode& parsed = tree.mNodes[node];
+        parsed.escaped = escaped;
+        parsed.valueStart = start - tree.mRecord.constData();
+        parsed.valueLength = p - start;
+        p++; //skip '"'
+        return true;
+    }
+    return false;
+}
+
+QByteArray GDBMIResultParser::unescape(const char *p, int length)
+{
+    const char* end = p+length;
+    QByteArray stringValue;
+    stringValue.reserve(length);
+    while (p<end) {
+        if (*p=='\\' && p+1<end) {
             p++;
             switch (*p) {
             case '\'':
@@ -206,14 +266,13 @@ bool GDBMIResultParser::parseStringValue(const char *&p, QByteArray& stringValue
             case '6':
             case '7':
             {
+                unsigned char ch = 0;
                 int i=0;
-                for (i=0;i<3;i++) {
+                for (i=0;i<3 && p+i<end;i++) {
                     if (*(p+i)<'0' || *(p+i)>'7')
                         break;
+                    ch = ch*8 + (*(p+i)-'0');
                 }
-                QByteArray numStr(p,i);
-                bool ok;
-                unsigned char ch = numStr.toInt(&ok,8);
                 stringValue+=ch;
                 p+=i;
                 break;
@@ -224,26 +283,22 @@ bool GDBMIResultParser::parseStringValue(const char *&p, QByteArray& stringValue
             p++;
         }
     }
-    if (*p=='"') {
-        p++; //skip '"'
-        return true;
-    }
-    return false;
+    return stringValue;
 }
 
-bool GDBMIResultParser::parseObject(const char *&p, ParseObject &obj)
+bool GDBMIResultParser::parseObject(const char *&p, ParseTree& tree, int node)
 {
     if (*p!='{')
         return false;
     p++;
 
     if (*p!='}') {
+        int lastChild = -1;
         while (*p!=0) {
-            QByteArray propName;
-            ParseValue propValue;
-            bool result = parseNameAndValue(p,propName,propValue);
+            int child;
+            bool result = parseNameAndValue(p,tree,child);
             if (result) {
-                obj[propName]=propValue;
+                appendChild(tree,node,lastChild,child);
             } else {
                 return false;
             }
@@ -264,33 +319,28 @@ bool GDBMIResultParser::parseObject(const char *&p, ParseObject &obj)
     return false;
 }
 
-bool GDBMIResultParser::parseArray(const char *&p, QList<GDBMIResultParser::ParseValue> &array)
+bool GDBMIResultParser::parseArray(const char *&p, ParseTree& tree, int node)
 {
     if (*p!='[')
         return false;
     p++;
     if (*p!=']') {
+        int lastChild = -1;
         while (*p!=0) {
             skipSpaces(p);
+            int child;
+            bool result;
             if (*p=='{' || *p=='"' || *p=='[') {
-                ParseValue val;
-                bool result = parseValue(p,val);
-                if (result) {
-                    array.append(val);
-                } else {
-                    return false;
-                }
+                result = parseValue(p,tree,child);
             } else {
-                QByteArray name;
-                ParseValue val;
-                bool result = parseNameAndValue(p,name,val);
-                if (result) {
-                    array.append(val);
-                } else {
-                    return false;
-                }
+                result = parseNameAndValue(p,tree,child);
             }
-            skipSpaces(p);            
+            if (result) {
+                appendChild(tree,node,lastChild,child);
+            } else {
+                return false;
+            }
+            skipSpaces(p);
             if (*p==']')
                 break;
             if (*p!=',')
@@ -335,26 +385,36 @@ void GDBMIResultParser::skipSpaces(const char *&p)
         p++;
 }
 
-const QByteArray &GDBMIResultParser::ParseValue::value() const
+QByteArray GDBMIResultParser::ParseValue::value() const
 {
-    return mValue;
+    if (!mTree || mTree->mNodes[mIndex].type!=ParseValueType::Value)
+        return QByteArray();
+    const ParseNode& node = mTree->mNodes[mIndex];
+    const char* p = mTree->mRecord.constData()+node.valueStart;
+    if (node.escaped)
+        return unescape(p,node.valueLength);
+    return QByteArray(p,node.valueLength);
 }
 
-const QList<::GDBMIResultParser::ParseValue> &GDBMIResultParser::ParseValue::array() const
+GDBMIResultParser::ParseArray GDBMIResultParser::ParseValue::array() const
 {
-    return mArray;
+    if (!mTree || mTree->mNodes[mIndex].type!=ParseValueType::Array)
+        return ParseArray();
+    return ParseArray(mTree,mIndex);
 }
 
-const GDBMIResultParser::ParseObject &GDBMIResultParser::ParseValue::object() const
+GDBMIResultParser::ParseObject GDBMIResultParser::ParseValue::object() const
 {
-    return mObject;
+    if (!mTree || mTree->mNodes[mIndex].type!=ParseValueType::Object)
+        return ParseObject();
+    return ParseObject(mTree,mIndex);
 }
 
 qlonglong GDBMIResultParser::ParseValue::intValue(int defaultValue) const
 {
     //Q_ASSERT(mType == ParseValueType::Value);
     bool ok;
-    qlonglong value = QString(mValue).toLongLong(&ok);
+    qlonglong value = this->value().toLongLong(&ok);
     if (ok)
         return value;
     else
@@ -364,14 +424,14 @@ qlonglong GDBMIResultParser::ParseValue::intValue(int defaultValue) const
 qulonglong GDBMIResultParser::ParseValue::hexValue(bool &ok) const
 {
     //Q_ASSERT(mType == ParseValueType::Value);
-    qulonglong value = QString(mValue).toULongLong(&ok,16);
+    qulonglong value = this->value().toULongLong(&ok,16);
     return value;
 }
 
 QString GDBMIResultParser::ParseValue::pathValue() const
 {
     //Q_ASSERT(mType == ParseValueType::Value);
-    QByteArray value=mValue;
+    QByteArray value=this->value();
 #ifdef Q_OS_WIN
     if (value.startsWith("/") && !value.startsWith("//"))
         value=value.mid(1);
@@ -381,7 +441,7 @@ QString GDBMIResultParser::ParseValue::pathValue() const
 
 QString GDBMIResultParser::ParseValue::utf8PathValue() const
 {
-    QByteArray value=mValue;
+    QByteArray value=this->value();
 #ifdef Q_OS_WIN
     if (value.startsWith("/") && !value.startsWith("//"))
         value=value.mid(1);
@@ -391,108 +451,129 @@ QString GDBMIResultParser::ParseValue::utf8PathValue() const
 
 GDBMIResultParser::ParseValueType GDBMIResultParser::ParseValue::type() const
 {
-    return mType;
+    if (!mTree)
+        return ParseValueType::NotAssigned;
+    return mTree->mNodes[mIndex].type;
 }
 
 bool GDBMIResultParser::ParseValue::isValid() const
 {
-    return mType!=ParseValueType::NotAssigned;
+    return mTree!=nullptr;
 }
 
 GDBMIResultParser::ParseValue::ParseValue():
-    mType(ParseValueType::NotAssigned) {
+    mTree(nullptr),
+    mIndex(-1)
+{
 
 }
 
-GDBMIResultParser::ParseValue::ParseValue(const QByteArray &value):
-    mValue(value),
-    mType(ParseValueType::Value)
+GDBMIResultParser::ParseValue::ParseValue(const ParseTree *tree, int index):
+    mTree(tree),
+    mIndex(index)
 {
 }
 
-GDBMIResultParser::ParseValue::ParseValue(const ParseObject &object):
-    mObject(object),
-    mType(ParseValueType::Object)
+GDBMIResultParser::ParseObject::ParseObject():
+    mTree(nullptr),
+    mIndex(-1)
 {
+
 }
 
-GDBMIResultParser::ParseValue::ParseValue(const QList<ParseValue> &array):
-    mArray(array),
-    mType(ParseValueType::Array)
+GDBMIResultParser::ParseObject::ParseObject(const ParseTree *tree, int index):
+    mTree(tree),
+    mIndex(index)
 {
+
 }
 
-GDBMIResultParser::ParseValue::ParseValue(const ParseValue &value):
-    mValue(value.mValue),
-    mArray(value.mArray),
-    mObject(value.mObject),
-    mType(value.mType)
+GDBMIResultParser::ParseValue GDBMIResultParser::ParseObject::operator[](const QByteArray &name) const
 {
+    if (!mTree)
+        return ParseValue();
+    const char* record = mTree->mRecord.constData();
+    int child = mTree->mNodes[mIndex].firstChild;
+    while (child>=0) {
+        const ParseNode& node = mTree->mNodes[child];
+        if (node.nameLength == name.length()
+                && memcmp(record+node.nameStart,name.constData(),node.nameLength)==0)
+            return ParseValue(mTree,child);
+        child = node.nextSibling;
+    }
+    return ParseValue();
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const GDBMIResultParser::ParseValue &value)
+GDBMIResultParser::ParseArray::ParseArray():
+    mTree(nullptr),
+    mIndex(-1)
 {
-    mType = value.mType;
-    mValue = value.mValue;
-    mArray = value.mArray;
-    mObject = value.mObject;
-    return *this;
+
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const QByteArray &value)
+GDBMIResultParser::ParseArray::ParseArray(const ParseTree *tree, int index):
+    mTree(tree),
+    mIndex(index)
 {
-    Q_ASSERT(mType == ParseValueType::NotAssigned);
-    mType = ParseValueType::Value;
-    mValue = value;
-    return *this;
+
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const ParseObject& object)
+GDBMIResultParser::ParseArray::const_iterator GDBMIResultParser::ParseArray::begin() const
 {
-    Q_ASSERT(mType == ParseValueType::NotAssigned);
-    mType = ParseValueType::Object;
-    mObject = object;
-    return *this;
+    if (!mTree)
+        return const_iterator(nullptr,-1);
+    return const_iterator(mTree,mTree->mNodes[mIndex].firstChild);
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const QList<ParseValue>& array)
+GDBMIResultParser::ParseArray::const_iterator GDBMIResultParser::ParseArray::end() const
 {
-    Q_ASSERT(mType == ParseValueType::NotAssigned);
-    mType = ParseValueType::Array;
-    mArray = array;
-    return *this;
+    return const_iterator(mTree,-1);
 }
 
+int GDBMIResultParser::ParseArray::count() const
+{
+    if (!mTree)
+        return 0;
+    return mTree->mNodes[mIndex].childCount;
+}
 
-GDBMIResultParser::ParseObject::ParseObject()
+GDBMIResultParser::ParseArray::const_iterator::const_iterator(const ParseTree *tree, int index):
+    mTree(tree),
+    mIndex(index)
 {
 
 }
 
-GDBMIResultParser::ParseObject::ParseObject(const ParseObject &object):
-    mProps(object.mProps)
+GDBMIResultParser::ParseValue GDBMIResultParser::ParseArray::const_iterator::operator*() const
 {
+    return ParseValue(mTree,mIndex);
+}
 
+GDBMIResultParser::ParseArray::const_iterator &GDBMIResultParser::ParseArray::const_iterator::operator++()
+{
+    mIndex = mTree->mNodes[mIndex].nextSibling;
+    return *this;
 }
 
-GDBMIResultParser::ParseValue GDBMIResultParser::ParseObject::operator[](const QByteArray &name) const
+bool GDBMIResultParser::ParseArray::const_iterator::operator!=(const const_iterator &other) const
 {
-    if (mProps.contains(name)) {
-        ParseValue value(mProps[name]);
-        return value;
-    }
-    return ParseValue();
+    return mIndex!=other.mIndex;
 }
 
-GDBMIResultParser::ParseObject &GDBMIResultParser::ParseObject::operator=(const ParseObject &object)
+GDBMIResultParser::ParseTree::ParseTree()
 {
-    mProps = object.mProps;
-    return *this;
+
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseObject::operator[](const QByteArray &name) {
-    if (!mProps.contains(name))
-        mProps[name]=ParseValue();
-    return mProps[name];
+GDBMIResultParser::ParseObject GDBMIResultParser::ParseTree::root() const
+{
+    if (mNodes.isEmpty())
+        return ParseObject();
+    return ParseObject(this,0);
 }
 
+void GDBMIResultParser::ParseTree::clear()
+{
+    mRecord.clear();
+    mNodes.clear();
+}
@@ -20,6 +20,7 @@
 #include <QByteArray>
 #include <QHash>
 #include <QList>
+#include <QVector>
 #include <memory>
 
 
@@ -51,29 +52,31 @@ public:
         NotAssigned
     };
 
-    class ParseValue;
-
-    class ParseObject {
-    public:
-        explicit ParseObject();
-        ParseObject(const ParseObject& object);
-        ParseValue operator[](const QByteArray& name) const;
-        ParseValue& operator[](const QByteArray& name);
-        ParseObject& operator=(const ParseObject& object);
-    private:
-        QHash<QByteArray, ParseValue> mProps;
+    //Parsed values are kept in a flat node array.
+    //Names and strings are offsets into the record, and are unescaped on access.
+    struct ParseNode {
+        ParseValueType type;
+        bool escaped;
+        int nameStart;
+        int nameLength;
+        int valueStart;
+        int valueLength;
+        int firstChild;
+        int childCount;
+        int nextSibling;
     };
 
+    class ParseTree;
+    class ParseObject;
+    class ParseArray;
+
     class ParseValue {
     public:
         explicit ParseValue();
-        explicit ParseValue(const QByteArray& value);
-        explicit ParseValue(const ParseObject &object);
-        explicit ParseValue(const QList<ParseValue>& array);
-        ParseValue(const ParseValue& value);
-        const QByteArray &value() const;
-        const QList<ParseValue> &array() const;
-        const ParseObject &object() const;
+        explicit ParseValue(const ParseTree* tree, int index);
+        QByteArray value() const;
+        ParseArray array() const;
+        ParseObject object() const;
         qlonglong intValue(int defaultValue=-1) const;
         qulonglong hexValue(bool &ok) const;
 
@@ -81,33 +84,78 @@ public:
         QString utf8PathValue() const;
         ParseValueType type() const;
         bool isValid() const;
-        ParseValue& operator=(const QByteArray& value);
-        ParseValue& operator=(const ParseObject& object);
-        ParseValue& operator=(const QList<ParseValue>& array);
-        ParseValue& operator=(const ParseValue& value);
     private:
-        QByteArray mValue;
-        QList<ParseValue> mArray;
-        ParseObject mObject;
-        ParseValueType mType;
+        const ParseTree* mTree;
+        int mIndex;
     };
 
-    using PParseValue = std::shared_ptr<ParseValue>;
+    class ParseObject {
+    public:
+        explicit ParseObject();
+        explicit ParseObject(const ParseTree* tree, int index);
+        ParseValue operator[](const QByteArray& name) const;
+    private:
+        const ParseTree* mTree;
+        int mIndex;
+    };
+
+    class ParseArray {
+    public:
+        class const_iterator {
+        public:
+            const_iterator(const ParseTree* tree, int index);
+            ParseValue operator*() const;
+            const_iterator& operator++();
+            bool operator!=(const const_iterator& other) const;
+        private:
+            const ParseTree* mTree;
+            int mIndex;
+        };
+        explicit ParseArray();
+        explicit ParseArray(const ParseTree* tree, int index);
+        const_iterator begin() const;
+        const_iterator end() const;
+        int count() const;
+    private:
+        const ParseTree* mTree;
+        int mIndex;
+    };
+
+    //Owns the record and the nodes; values handed out by it must not outlive it.
+    class ParseTree {
+    public:
+        explicit ParseTree();
+        ParseTree(const ParseTree&) = delete;
+        ParseTree& operator=(const ParseTree&) = delete;
+        ParseObject root() const;
+        void clear();
+    private:
+        QByteArray mRecord;
+        QVector<ParseNode> mNodes;
+        friend class GDBMIResultParser;
+        friend class ParseValue;
+        friend class ParseObject;
+        friend class ParseArray;
+        friend class ParseArray::const_iterator;
+    };
 
 public:
     GDBMIResultParser();
-    bool parse(const QByteArray& record, const QString& command, GDBMIResultType& type, ParseObject& multiValues);
-    bool parseAsyncResult(const QByteArray& record, QByteArray& result, ParseObject& multiValue);
+    bool parse(const QByteArray& record, int start, const QString& command, GDBMIResultType& type, ParseTree& tree);
+    bool parseAsyncResult(const QByteArray& record, QByteArray& result, ParseTree& tree);
 private:
-    bool parseMultiValues(const char*p, ParseObject& multiValue);
-    bool parseNameAndValue(const char *&p,QByteArray& name, ParseValue& value);
-    bool parseValue(const char* &p, ParseValue& value);
-    bool parseStringValue(const char*&p, QByteArray& stringValue);
-    bool parseObject(const char*&p, ParseObject& obj);
-    bool parseArray(const char*&p, QList<ParseValue>& array);
+    int newNode(ParseTree& tree, ParseValueType type);
+    bool parseMultiValues(const char* p, ParseTree& tree, int parent);
+    bool parseNameAndValue(const char *&p, ParseTree& tree, int& node);
+    bool parseValue(const char* &p, ParseTree& tree, int& node);
+    bool parseStringValue(const char*&p, ParseTree& tree, int node);
+    bool parseObject(const char*&p, ParseTree& tree, int node);
+    bool parseArray(const char*&p, ParseTree& tree, int node);
+    void appendChild(ParseTree& tree, int parent, int& lastChild, int child);
     void skipSpaces(const char* &p);
     bool isNameChar(char ch);
     bool isSpaceChar(char ch);
+    static QByteArray unescape(const char* p, int length);
 private:
     QHash<QString, GDBMIResultType> mResultTypes;
 };
@@ -37,6 +37,7 @@
 #include "editorlist.h"
 #include "widgets/choosethemedialog.h"
 #include "thememanager.h"
+#include "widgets/searchresultview.h"
 
 #ifdef Q_OS_WIN
 #include <QTemporaryFile>
@@ -319,6 +320,7 @@ int main(int argc, char *argv[])
     qRegisterMetaType<PCompileIssue>("PCompileIssue&");
     qRegisterMetaType<QVector<int>>("QVector<int>");
     qRegisterMetaType<QHash<int,QString>>("QHash<int,QString>");
+    qRegisterMetaType<PSearchResultTreeItemList>("PSearchResultTreeItemList");
 
     initParser();
 
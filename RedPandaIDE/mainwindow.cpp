@@ -34,7 +34,6 @@
 #include "thememanager.h"
 #include "widgets/darkfusionstyle.h"
 #include "widgets/lightfusionstyle.h"
-#include "problems/problemcasevalidator.h"
 #include "problems/freeprojectsetformat.h"
 #include "widgets/ojproblempropertywidget.h"
 #include "iconsmanager.h"
@@ -97,6 +96,8 @@
 #include <windows.h>
 #endif
 
+//how long refactorings wait for the queued parses before they give up
+#define PARSER_WAIT_TIMEOUT 10000
 
 static int findTabIndex(QTabWidget* tabWidget , QWidget* w) {
     for (int i=0;i<tabWidget->count();i++) {
@@ -117,6 +118,7 @@ MainWindow::MainWindow(QWidget *parent)
       mQuitting{false},
       mClosingProject{false},
       mCheckSyntaxInBack{false},
+      mCheckSyntaxPending{false},
       mShouldRemoveAllSettings{false},
       mClosing{false},
       mClosingAll{false},
@@ -1878,14 +1880,15 @@ void MainWindow::checkSyntaxInBack(Editor *e)
             && fileType != FileType::GAS
             )
         return;
-    if (mCompilerManager->backgroundSyntaxChecking())
+    if (mCompilerManager->backgroundSyntaxChecking() || mCheckSyntaxInBack) {
+        //check again when the running one finished
+        mCheckSyntaxPending = true;
         return;
+    }
     if (mCompilerManager->compiling())
         return;
     if (!pSettings->compilerSets().defaultSet())
         return;
-    if (mCheckSyntaxInBack)
-        return;
 
     if (mCompileIssuesState==CompileIssuesState::ProjectCompilationResultFilled
             || mCompileIssuesState==CompileIssuesState::ProjectCompiling) {
@@ -2402,6 +2405,15 @@ void MainWindow::showSearchPanel(bool showReplace)
     ui->tabMessages->setCurrentWidget(ui->tabSearch);
 }
 
+void MainWindow::setSearchInFilesRunning(bool running)
+{
+    ui->btnStopSearch->setEnabled(running);
+    //don't replace in results that are still filling
+    ui->btnReplace->setEnabled(!running);
+    if (!running)
+        updateStatusbarMessage("");
+}
+
 void MainWindow::showCPUInfoDialog()
 {
     if (mCPUDialog==nullptr) {
@@ -5625,8 +5637,10 @@ void MainWindow::onSyntaxCheckStarted()
 void MainWindow::onCompileFinished(QString filename, bool isCheckSyntax)
 {
     if (mQuitting) {
-        if (isCheckSyntax)
+        if (isCheckSyntax) {
             mCheckSyntaxInBack = false;
+            mCheckSyntaxPending = false;
+        }
         else
             mCompileSuccessionTask = nullptr;
         return;
@@ -5796,6 +5810,12 @@ void MainWindow::onCompileFinished(QString filename, bool isCheckSyntax)
         }
     } else {
         mCheckSyntaxInBack=false;
+        if (mCheckSyntaxPending) {
+            mCheckSyntaxPending=false;
+            Editor * editor = mEditorList->getEditor();
+            if (editor)
+                editor->checkSyntaxInBack();
+        }
     }
     updateCompileActions();
     updateAppTitle();
@@ -5852,13 +5872,13 @@ void MainWindow::onOJProblemCaseStarted(const QString& id,int current, int total
     }
 }
 
-void MainWindow::onOJProblemCaseFinished(const QString& id, int current, int total)
+void MainWindow::onOJProblemCaseFinished(const QString& id, int current, int total, bool passed)
 {
     int row = mOJProblemModel.getCaseIndexById(id);
     if (row>=0) {
         POJProblemCase problemCase = mOJProblemModel.getCase(row);
-        ProblemCaseValidator validator;
-        problemCase->testState = validator.validate(problemCase,pSettings->executor().ignoreSpacesWhenValidatingCases())?
+        //validated by the runner while the output was produced
+        problemCase->testState = passed?
                     ProblemCaseTestState::Passed:
                     ProblemCaseTestState::Failed;
         mOJProblemModel.update(row);
@@ -6422,6 +6442,12 @@ void MainWindow::on_btnSearchAgain_clicked()
     }
 }
 
+void MainWindow::on_btnStopSearch_clicked()
+{
+    if (mSearchInFilesDialog)
+        mSearchInFilesDialog->stopSearch();
+}
+
 void MainWindow::on_actionRemove_Watch_triggered()
 {
     QModelIndexList lst=ui->watchView->selectionModel()->selectedRows();
@@ -7700,6 +7726,19 @@ void MainWindow::on_actionAbout_triggered()
 }
 
 
+bool MainWindow::waitForParser(Editor *editor, const PCppParser &parser)
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool parsed = parser->waitForParseQueue(PARSER_WAIT_TIMEOUT);
+    QApplication::restoreOverrideCursor();
+    if (!parsed) {
+        QMessageBox::information(editor,
+                                 tr("Rename Symbol"),
+                                 tr("The parser is still busy, please try again later."));
+    }
+    return parsed;
+}
+
 void MainWindow::on_actionRename_Symbol_triggered()
 {
     Editor * editor = mEditorList->getEditor();
@@ -7729,9 +7768,12 @@ void MainWindow::on_actionRename_Symbol_triggered()
         for (int i=0;i<mEditorList->pageCount();i++) {
             Editor * e=(*mEditorList)[i];
             if (e->modified())  {
-                mProject->cppParser()->parseFile(editor->filename(), editor->inProject(), false, false);
+                mProject->cppParser()->queueParseFile(e->filename(), e->inProject(), false, false);
             }
         }
+        //don't look for the symbol in stale statements
+        if (!waitForParser(editor, mProject->cppParser()))
+            return;
 
         // Find it's definition
         PStatement oldStatement = editor->parser()->findStatementOf(
@@ -7786,7 +7828,9 @@ void MainWindow::on_actionRename_Symbol_triggered()
     if (!editor->inProject() && editor->modified() ) {
         PCppParser parser = editor->parser();
         //here we must reparse the file in sync, or rename may fail
-        parser->parseFile(editor->filename(), editor->inProject(), false, false);
+        parser->queueParseFile(editor->filename(), editor->inProject(), false, false);
+        if (!waitForParser(editor, parser))
+            return;
     }
     CppRefacter refactor;
 
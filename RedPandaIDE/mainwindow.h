@@ -151,6 +151,7 @@ public:
     void runExecutable(RunType runType = RunType::Normal);
     void debug();
     void showSearchPanel(bool showReplace = false);
+    void setSearchInFilesRunning(bool running);
     void showCPUInfoDialog();
 
     void setFilesViewRoot(const QString& path, bool setOpenFolder=false);
@@ -246,7 +247,7 @@ public slots:
     void onRunPausingForFinish();
     void onRunProblemFinished();
     void onOJProblemCaseStarted(const QString& id, int current, int total);
-    void onOJProblemCaseFinished(const QString& id, int current, int total);
+    void onOJProblemCaseFinished(const QString& id, int current, int total, bool passed);
     void onOJProblemCaseNewOutputGetted(const QString& id, const QString& line);
     void onOJProblemCaseResetOutput(const QString& id, const QString& line);
     void cleanUpCPUDialog();
@@ -288,6 +289,7 @@ private:
     void stretchExplorerPanel(bool open);
     void prepareDebugger();
     void doAutoSave(Editor *e);
+    bool waitForParser(Editor* editor, const PCppParser& parser);
     void createCustomActions();
     void initToolButtons();
     void buildContextMenus();
@@ -512,6 +514,7 @@ private slots:
     void on_cbSearchHistory_currentIndexChanged(int index);
 
     void on_btnSearchAgain_clicked();
+    void on_btnStopSearch_clicked();
     void on_actionRemove_Watch_triggered();
 
     void on_actionRemove_All_Watches_triggered();
@@ -861,6 +864,8 @@ private:
     QString mFilesViewNewCreatedFolder;
 
     bool mCheckSyntaxInBack;
+    //edits arrived while a syntax check was running
+    bool mCheckSyntaxPending;
     bool mShouldRemoveAllSettings;
     PCompileSuccessionTask mCompileSuccessionTask;
 
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "cppincludegraph.h"
+#include <QQueue>
+
+CppIncludeGraph::CppIncludeGraph()
+{
+
+}
+
+void CppIncludeGraph::clear()
+{
+    mFileIds.clear();
+    mFileNames.clear();
+    mIncludes.clear();
+    mIncludedBy.clear();
+}
+
+void CppIncludeGraph::addInclude(const QString &fileName, const QString &includedFile)
+{
+    int from = fileId(fileName);
+    int to = fileId(includedFile);
+    if (from == to || mIncludes[from].contains(to))
+        return;
+    mIncludes[from].append(to);
+    mIncludedBy[to].append(from);
+}
+
+void CppIncludeGraph::removeIncludes(const QString &fileName)
+{
+    int id = mFileIds.value(fileName,-1);
+    if (id<0)
+        return;
+    foreach (int to, mIncludes[id]) {
+        mIncludedBy[to].removeOne(id);
+    }
+    mIncludes[id].clear();
+}
+
+QSet<QString> CppIncludeGraph::dependents(const QString &fileName) const
+{
+    QSet<QString> result;
+    int id = mFileIds.value(fileName,-1);
+    if (id<0)
+        return result;
+    QVector<bool> visited(mFileNames.count(),false);
+    QQueue<int> queue;
+    visited[id] = true;
+    queue.enqueue(id);
+    while (!queue.isEmpty()) {
+        int current = queue.dequeue();
+        foreach (int from, mIncludedBy[current]) {
+            if (visited[from])
+                continue;
+            visited[from] = true;
+            result.insert(mFileNames[from]);
+            queue.enqueue(from);
+        }
+    }
+    return result;
+}
+
+QStringList CppIncludeGraph::sortByIncludeRelations(const QSet<QString> &files) const
+{
+    QStringList result;
+    //files not in the graph don't include anything we know of
+    QStringList unknownFiles;
+    //collect files in the set and all files included by them
+    QVector<bool> inSubGraph(mFileNames.count(),false);
+    QVector<int> nodes;
+    QQueue<int> queue;
+    foreach (const QString& file, files) {
+        int id = mFileIds.value(file,-1);
+        if (id<0) {
+            unknownFiles.append(file);
+            continue;
+        }
+        if (!inSubGraph[id]) {
+            inSubGraph[id] = true;
+            nodes.append(id);
+            queue.enqueue(id);
+        }
+    }
+    while (!queue.isEmpty()) {
+        int current = queue.dequeue();
+        foreach (int to, mIncludes[current]) {
+            if (!inSubGraph[to]) {
+                inSubGraph[to] = true;
+                nodes.append(to);
+                queue.enqueue(to);
+            }
+        }
+    }
+    //Kahn's algorithm, starting from files not included by others
+    QVector<int> inDegrees(mFileNames.count(),0);
+    foreach (int id, nodes) {
+        foreach (int to, mIncludes[id])
+            inDegrees[to]++;
+    }
+    QVector<bool> done(mFileNames.count(),false);
+    int doneCount = 0;
+    int nextNode = 0;
+    foreach (int id, nodes) {
+        if (inDegrees[id]==0)
+            queue.enqueue(id);
+    }
+    while (doneCount < nodes.count()) {
+        if (queue.isEmpty()) {
+            //include cycle, break it at the first remaining file
+            while (done[nodes[nextNode]])
+                nextNode++;
+            queue.enqueue(nodes[nextNode]);
+            inDegrees[nodes[nextNode]] = 0;
+        }
+        int current = queue.dequeue();
+        if (done[current])
+            continue;
+        done[current] = true;
+        doneCount++;
+        if (files.contains(mFileNames[current]))
+            result.append(mFileNames[current]);
+        foreach (int to, mIncludes[current]) {
+            if (!done[to] && --inDegrees[to]==0)
+                queue.enqueue(to);
+        }
+    }
+    result.append(unknownFiles);
+    return result;
+}
+
+int CppIncludeGraph::fileId(const QString &fileName)
+{
+    int id = mFileIds.value(fileName,-1);
+    if (id<0) {
+        id = mFileNames.count();
+        mFileIds.insert(fileName,id);
+        mFileNames.append(fileName);
+        mIncludes.append(QVector<int>());
+        mIncludedBy.append(QVector<int>());
+    }
+    return id;
+}
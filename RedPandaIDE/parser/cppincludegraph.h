@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CPPINCLUDEGRAPH_H
+#define CPPINCLUDEGRAPH_H
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+//Direct include relations between files.
+//Files are interned as ids, and both directions are kept so
+//dependents of a file can be found without scanning all files.
+class CppIncludeGraph
+{
+public:
+    explicit CppIncludeGraph();
+    void clear();
+    void addInclude(const QString& fileName, const QString& includedFile);
+    //remove the includes of the file (it will be rescanned)
+    void removeIncludes(const QString& fileName);
+    //files including fileName directly or indirectly
+    QSet<QString> dependents(const QString& fileName) const;
+    //files in the set, includers are placed before the files they include
+    QStringList sortByIncludeRelations(const QSet<QString>& files) const;
+private:
+    int fileId(const QString& fileName);
+private:
+    QHash<QString,int> mFileIds;
+    QStringList mFileNames;
+    QVector<QVector<int>> mIncludes;
+    QVector<QVector<int>> mIncludedBy;
+};
+
+#endif // CPPINCLUDEGRAPH_H
@@ -20,14 +20,46 @@
 #include "qsynedit/syntaxer/cpp.h"
 
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDate>
+#include <QDir>
+#include <QFileInfo>
 #include <QHash>
 #include <QQueue>
+#include <QSemaphore>
 #include <QThread>
+#include <QThreadPool>
 #include <QTime>
+#include <QSaveFile>
 
 static QAtomicInt cppParserCount(0);
 
+#define SYSTEM_HEADER_CACHE_MAGIC 0x52504843
+#define SYSTEM_HEADER_CACHE_VERSION 1
+#define LOOKUP_CACHE_MAX_SIZE 1000
+//prune the string pool after it grows by this many strings
+#define STRING_POOL_PRUNE_GROWTH 1000
+
+static QString memberNameOf(const QString& phrase)
+{
+    QString s = phrase;
+    //remove []
+    int p = phrase.indexOf('[');
+    if (p>=0)
+        s.truncate(p);
+    //remove ()
+    p = phrase.indexOf('(');
+    if (p>=0)
+        s.truncate(p);
+
+    //remove <>
+    p =s.indexOf('<');
+    if (p>=0)
+        s.truncate(p);
+    return s;
+}
+
 CppParser::CppParser(QObject *parent) : QObject(parent),
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
     mMutex()
@@ -59,6 +91,15 @@ CppParser::CppParser(QObject *parent) : QObject(parent),
     mCppKeywords = CppKeywords;
     mCppTypeKeywords = CppTypeKeywords;
     mEnabled = true;
+    mSystemHeaderCacheChecked = false;
+    mSystemHeaderModified = false;
+    mParseWorker = nullptr;
+    mQuitParseWorker = false;
+    mProcessingParseRequest = false;
+    mStringPoolPrunedSize = 0;
+    mParsedRequestCount = 0;
+    mLastParseLatency = 0;
+    mMaxParseLatency = 0;
 
     internalClear();
 
@@ -70,6 +111,11 @@ CppParser::CppParser(QObject *parent) : QObject(parent),
 
 CppParser::~CppParser()
 {
+    {
+        QMutexLocker locker(&mParseQueueMutex);
+        mQuitParseWorker = true;
+        mParseQueueCondition.wakeAll();
+    }
     while (true) {
         //wait for all methods finishes running
         {
@@ -83,6 +129,10 @@ CppParser::~CppParser()
         QCoreApplication* app = QApplication::instance();
         app->processEvents();
     }
+    if (mParseWorker) {
+        mParseWorker->wait();
+        delete mParseWorker;
+    }
     //qDebug()<<"-------- parser deleted ------------";
 }
 
@@ -278,10 +328,29 @@ PStatement CppParser::findStatementOf(const QString &fileName,
                                       bool force)
 {
     QMutexLocker locker(&mMutex);
-    PStatement result;
     parentScopeType = currentScope;
-    if (mParsing && !force)
-        return PStatement();
+    if (mParsing) {
+        if (!force)
+            return PStatement();
+        return internalFindStatementOf(fileName,phrase,currentScope,parentScopeType);
+    }
+    QString key = lookupCacheKey(fileName,currentScope,phrase);
+    QHash<QString,QPair<PStatement,PStatement>>::const_iterator it = mLookupCache.constFind(key);
+    if (it!=mLookupCache.constEnd()) {
+        parentScopeType = it.value().second;
+        return it.value().first;
+    }
+    PStatement statement = internalFindStatementOf(fileName,phrase,currentScope,parentScopeType);
+    addToLookupCache(key,statement,parentScopeType);
+    return statement;
+}
+
+PStatement CppParser::internalFindStatementOf(const QString &fileName,
+                                              const QString &phrase,
+                                              const PStatement& currentScope,
+                                              PStatement &parentScopeType)
+{
+    parentScopeType = currentScope;
 
     //find the start scope statement
     QString namespaceName, remainder;
@@ -444,6 +513,17 @@ PStatement CppParser::findStatementOf(const QString &fileName, const QStringList
     QMutexLocker locker(&mMutex);
     if (mParsing)
         return PStatement();
+    QString key = lookupCacheKey(fileName,currentScope,expression.join(' '));
+    QHash<QString,QPair<PStatement,PStatement>>::const_iterator it = mLookupCache.constFind(key);
+    if (it!=mLookupCache.constEnd())
+        return it.value().first;
+    PStatement statement = internalFindStatementOf(fileName,expression,currentScope);
+    addToLookupCache(key,statement,PStatement());
+    return statement;
+}
+
+PStatement CppParser::internalFindStatementOf(const QString &fileName, const QStringList &expression, const PStatement &currentScope)
+{
     QString memberOperator;
     QStringList memberExpression;
     QStringList ownerExpression = getOwnerExpressionAndMember(expression,memberOperator,memberExpression);
@@ -524,8 +604,29 @@ PStatement CppParser::findAliasedStatement(const PStatement &statement)
     return PStatement();
 }
 
+QString CppParser::lookupCacheKey(const QString &fileName, const PStatement &scope, const QString &phrase) const
+{
+    return QString("%1\n%2\n%3").arg(fileName).arg((quintptr)scope.get()).arg(phrase);
+}
+
+void CppParser::addToLookupCache(const QString &key, const PStatement &statement, const PStatement &parentScopeType)
+{
+    if (mLookupCache.size()>=LOOKUP_CACHE_MAX_SIZE)
+        mLookupCache.clear();
+    mLookupCache.insert(key,QPair<PStatement,PStatement>(statement,parentScopeType));
+}
+
+void CppParser::clearLookupCaches()
+{
+    mLookupCache.clear();
+    mFileUsingsCache.clear();
+}
+
 PStatement CppParser::findStatementStartingFrom(const QString &fileName, const QString &phrase, const PStatement& startScope)
 {
+    //no statement with this name, no need to walk the scopes and usings
+    if (!mStatementList.containsName(memberNameOf(phrase)))
+        return PStatement();
     PStatement scopeStatement = startScope;
 
     // repeat until reach global
@@ -640,7 +741,7 @@ QStringList CppParser::getClassesList()
         for (PStatement& child:statementMap) {
             if (child->kind == StatementKind::skClass)
                 list.append(child->command);
-            if (!child->children.isEmpty())
+            if (!mStatementList.childrenStatements(child).isEmpty())
                 queue.enqueue(child);
         }
     }
@@ -690,6 +791,9 @@ QSet<QString> CppParser::getFileUsings(const QString &filename)
         return result;
     if (mParsing)
         return result;
+    QHash<QString,QSet<QString>>::const_iterator it = mFileUsingsCache.constFind(filename);
+    if (it!=mFileUsingsCache.constEnd())
+        return it.value();
     PFileIncludes fileIncludes= mPreprocessor.includesList().value(filename,PFileIncludes());
     if (fileIncludes) {
         foreach (const QString& usingName, fileIncludes->usings) {
@@ -704,6 +808,7 @@ QSet<QString> CppParser::getFileUsings(const QString &filename)
             }
         }
     }
+    mFileUsingsCache.insert(filename,result);
     return result;
 }
 
@@ -750,6 +855,7 @@ void CppParser::invalidateFile(const QString &fileName)
             return;
         updateSerialId();
         mParsing = true;
+        clearLookupCaches();
     }
     QSet<QString> files = calculateFilesToBeReparsed(fileName);
     internalInvalidateFiles(files);
@@ -790,16 +896,17 @@ bool CppParser::isSystemHeaderFile(const QString &fileName)
     return ::isSystemHeaderFile(fileName,mPreprocessor.includePaths());
 }
 
-void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNotParsed, bool updateView)
+bool CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNotParsed, bool updateView)
 {
     if (!mEnabled)
-        return;
+        return true;
     {
         QMutexLocker locker(&mMutex);
         if (mParsing || mLockCount>0)
-            return;
+            return false;
         updateSerialId();
         mParsing = true;
+        clearLookupCaches();
         if (updateView)
             emit onBusy();
         emit onStartParsing();
@@ -813,9 +920,13 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
             else
                 emit onEndParsing(mFilesScannedCount,0);
         });
+        if (!mSystemHeaderCacheChecked) {
+            mSystemHeaderCacheChecked = true;
+            loadSystemHeaderCache();
+        }
         QString fName = fileName;
         if (onlyIfNotParsed && mPreprocessor.scannedFiles().contains(fName))
-            return;
+            return true;
 
         if (inProject) {
             QSet<QString> filesToReparsed = calculateFilesToBeReparsed(fileName);
@@ -825,13 +936,7 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
             mFilesToScanCount = files.count();
             mFilesScannedCount = 0;
 
-            foreach (const QString& file,files) {
-                mFilesScannedCount++;
-                emit onProgress(file,mFilesToScanCount,mFilesScannedCount);
-                if (!mPreprocessor.scannedFiles().contains(file)) {
-                    internalParse(file);
-                }
-            }
+            internalParseFiles(files);
         } else {
             internalInvalidateFile(fileName);
             mFilesToScanCount = 1;
@@ -841,6 +946,7 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
             emit onProgress(fileName,mFilesToScanCount,mFilesScannedCount);
             internalParse(fileName);
         }
+        saveSystemHeaderCache();
 
 //        if (inProject)
 //            mProjectFiles.insert(fileName);
@@ -851,18 +957,150 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
         // Parse from disk or stream
 
     }
+    return true;
+}
+
+static bool isInFunctionBody(PStatement statement, const PStatement& function)
+{
+    while (statement && statement != function && statement->kind == StatementKind::skBlock)
+        statement = statement->parentScope.lock();
+    return statement && statement == function;
+}
+
+bool CppParser::parseFunctionBody(const QString &fileName, int firstLine, int lastLine, int lineDelta)
+{
+    if (!mEnabled || parseQueueDepth()>0)
+        return false;
+    {
+        QMutexLocker locker(&mMutex);
+        if (mParsing || mLockCount>0)
+            return false;
+        if (mSystemHeaderIndex && mSystemHeaderIndex->files.contains(fileName))
+            return false;
+        PFileIncludes fileIncludes = mPreprocessor.includesList().value(fileName);
+        if (!fileIncludes || !mPreprocessor.scannedFiles().contains(fileName))
+            return false;
+
+        //find the function whose body contains the edited lines
+        const QVector<PCppScope>& scopes = fileIncludes->scopes.scopes();
+        int index = scopes.size()-1;
+        while (index>=0 && scopes[index]->startLine>=firstLine)
+            index--;
+        if (index<0)
+            return false;
+        PStatement function = scopes[index]->statement;
+        while (function && function->kind == StatementKind::skBlock)
+            function = function->parentScope.lock();
+        if (!function || function->isShared()
+                || function->definitionFileName != fileName
+                || (function->kind != StatementKind::skFunction
+                    && function->kind != StatementKind::skConstructor
+                    && function->kind != StatementKind::skDestructor))
+            return false;
+        int startIndex = index;
+        while (startIndex>0 && isInFunctionBody(scopes[startIndex-1]->statement,function))
+            startIndex--;
+        int endIndex = index+1;
+        while (endIndex<scopes.size() && isInFunctionBody(scopes[endIndex]->statement,function))
+            endIndex++;
+        if (scopes[startIndex]->statement != function || endIndex>=scopes.size())
+            return false;
+        // line numbers before the edit
+        int functionLine = scopes[startIndex]->startLine;
+        int closeLine = scopes[endIndex]->startLine;
+        PStatement outerScope = scopes[endIndex]->statement;
+        if (firstLine<=functionLine || std::max(firstLine,lastLine-lineDelta)>=closeLine)
+            return false;
+        int newCloseLine = closeLine + lineDelta;
+
+        QStringList buffer;
+        if (!mPreprocessor.preprocessLines(fileName,functionLine,newCloseLine,buffer))
+            return false;
+        buffer.prepend(QString("#include %1:%2").arg(fileName).arg(functionLine));
+        mTokenizer.tokenize(buffer);
+        auto action = finally([this]{
+            internalClear();
+            mTokenizer.clear();
+        });
+        //the body must still end at the old '}', and its '{' must be before the edited lines
+        int bodyEnd = mTokenizer.tokenCount()-1;
+        if (bodyEnd<2 || !mTokenizer.bracesMatched()
+                || !mTokenizer[0]->text.startsWith('#')
+                || mTokenizer[bodyEnd]->text!='}'
+                || mTokenizer[bodyEnd]->line!=newCloseLine)
+            return false;
+        int bodyStart = mTokenizer[bodyEnd]->matchIndex;
+        if (bodyStart<1 || mTokenizer[bodyStart]->line>=firstLine)
+            return false;
+
+        mParsing = true;
+        clearLookupCaches();
+        emit onStartParsing();
+        auto action2 = finally([this]{
+            mParsing = false;
+        });
+        //parameters are declared in the function header, which is not changed
+        const StatementList children = function->children.values();
+        foreach (const PStatement& child, children) {
+            if (child->kind != StatementKind::skParameter)
+                removeStatementTree(child, fileIncludes);
+        }
+        function->usingList.clear();
+        if (lineDelta!=0) {
+            foreach (const PStatement& statement, fileIncludes->statements) {
+                if (statement->fileName == fileName && statement->line>=closeLine)
+                    statement->line += lineDelta;
+                if (statement->definitionFileName == fileName && statement->definitionLine>=closeLine)
+                    statement->definitionLine += lineDelta;
+            }
+        }
+        QVector<PCppScope> oldScopes = fileIncludes->scopes.takeScopesFrom(startIndex+1);
+
+        //handle the body as if we've just entered the function
+        internalClear();
+        mIndex = 0;
+        handlePreprocessor();
+        mCurrentScope.append(outerScope);
+        mCurrentClassScope.append(StatementClassScope::None);
+        mCurrentScope.append(function);
+        mCurrentClassScope.append(StatementClassScope::Public);
+        mClassScope = StatementClassScope::Public;
+        mIndex = bodyStart+1;
+#ifdef QT_DEBUG
+        mLastIndex = -1;
+#endif
+        while(true) {
+            if (!handleStatement())
+                break;
+        }
+        //the closing scope is added again when handling the last '}'
+        fileIncludes->scopes.appendScopes(oldScopes.mid(endIndex-startIndex),lineDelta);
+    }
+    emit onEndParsing(1,0);
+    return true;
 }
 
-void CppParser::parseFileList(bool updateView)
+void CppParser::removeStatementTree(const PStatement &statement, const PFileIncludes &fileIncludes)
+{
+    const StatementList children = statement->children.values();
+    foreach (const PStatement& child, children) {
+        removeStatementTree(child, fileIncludes);
+    }
+    mStatementList.deleteStatement(statement);
+    fileIncludes->statements.remove(statement->fullName,statement);
+}
+
+bool CppParser::parseFileList(bool updateView)
 {
     if (!mEnabled)
-        return;
+        return true;
     {
         QMutexLocker locker(&mMutex);
         if (mParsing || mLockCount>0)
-            return;
+            return false;
         updateSerialId();
         mParsing = true;
+        clearLookupCaches();
         if (updateView)
             emit onBusy();
         emit onStartParsing();
@@ -875,20 +1113,139 @@ void CppParser::parseFileList(bool updateView)
             else
                 emit onEndParsing(mFilesScannedCount,0);
         });
+        if (!mSystemHeaderCacheChecked) {
+            mSystemHeaderCacheChecked = true;
+            loadSystemHeaderCache();
+        }
         // Support stopping of parsing when files closes unexpectedly
         mFilesScannedCount = 0;
         mFilesToScanCount = mFilesToScan.count();
 
         QStringList files = sortFilesByIncludeRelations(mFilesToScan);
         // parse header files in the first parse
-        foreach (const QString& file, files) {
-            mFilesScannedCount++;
-            emit onProgress(mCurrentFile,mFilesToScanCount,mFilesScannedCount);
-            if (!mPreprocessor.scannedFiles().contains(file)) {
-                internalParse(file);
+        internalParseFiles(files);
+        mFilesToScan.clear();
+        saveSystemHeaderCache();
+    }
+    return true;
+}
+
+void CppParser::queueParseFile(const QString &fileName, bool inProject, bool onlyIfNotParsed, bool updateView)
+{
+    if (fileName.isEmpty())
+        return;
+    queueParseRequest(fileName,inProject,onlyIfNotParsed,updateView);
+}
+
+void CppParser::queueParseFileList(bool updateView)
+{
+    queueParseRequest(QString(),false,false,updateView);
+}
+
+bool CppParser::waitForParseQueue(int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QMutexLocker locker(&mParseQueueMutex);
+    while (!mParseQueue.isEmpty() || mProcessingParseRequest) {
+        qint64 remaining = msecs - timer.elapsed();
+        if (remaining<=0)
+            return false;
+        mParseQueueCondition.wait(&mParseQueueMutex, remaining);
+    }
+    return true;
+}
+
+int CppParser::parseQueueDepth()
+{
+    QMutexLocker locker(&mParseQueueMutex);
+    return mParseQueue.count();
+}
+
+int CppParser::parsedRequestCount()
+{
+    QMutexLocker locker(&mParseQueueMutex);
+    return mParsedRequestCount;
+}
+
+qint64 CppParser::lastParseLatency()
+{
+    QMutexLocker locker(&mParseQueueMutex);
+    return mLastParseLatency;
+}
+
+qint64 CppParser::maxParseLatency()
+{
+    QMutexLocker locker(&mParseQueueMutex);
+    return mMaxParseLatency;
+}
+
+void CppParser::queueParseRequest(const QString &fileName, bool inProject, bool onlyIfNotParsed, bool updateView)
+{
+    QMutexLocker locker(&mParseQueueMutex);
+    foreach (const PParseRequest& request, mParseQueue) {
+        if (request->fileName == fileName) {
+            //the pending request will parse the latest content, keep its queued time
+            request->inProject = inProject;
+            request->onlyIfNotParsed = request->onlyIfNotParsed && onlyIfNotParsed;
+            request->updateView = request->updateView || updateView;
+            return;
+        }
+    }
+    PParseRequest request = std::make_shared<ParseRequest>();
+    request->fileName = fileName;
+    request->inProject = inProject;
+    request->onlyIfNotParsed = onlyIfNotParsed;
+    request->updateView = updateView;
+    request->timer.start();
+    mParseQueue.append(request);
+    if (!mParseWorker) {
+        mParseWorker = new CppParserWorker(this);
+        mParseWorker->start();
+    }
+    mParseQueueCondition.wakeAll();
+}
+
+void CppParser::processParseRequests()
+{
+    while (true) {
+        PParseRequest request;
+        {
+            QMutexLocker locker(&mParseQueueMutex);
+            while (!mQuitParseWorker && mParseQueue.isEmpty())
+                mParseQueueCondition.wait(&mParseQueueMutex);
+            if (mQuitParseWorker)
+                return;
+            request = mParseQueue.takeFirst();
+            mProcessingParseRequest = true;
+        }
+        bool parsed;
+        if (request->fileName.isEmpty())
+            parsed = parseFileList(request->updateView);
+        else
+            parsed = parseFile(request->fileName,request->inProject,
+                               request->onlyIfNotParsed,request->updateView);
+        QMutexLocker locker(&mParseQueueMutex);
+        mProcessingParseRequest = false;
+        //wake up the waiters of waitForParseQueue()
+        mParseQueueCondition.wakeAll();
+        if (!parsed) {
+            //parser is busy or frozen, retry later unless a newer request for the file is queued
+            bool superseded = false;
+            foreach (const PParseRequest& r, mParseQueue) {
+                if (r->fileName == request->fileName) {
+                    superseded = true;
+                    break;
+                }
             }
+            if (!superseded)
+                mParseQueue.prepend(request);
+            mParseQueueCondition.wait(&mParseQueueMutex,50);
+            continue;
         }
-        mFilesToScan.clear();
+        mParsedRequestCount++;
+        mLastParseLatency = request->timer.elapsed();
+        mMaxParseLatency = std::max(mMaxParseLatency,mLastParseLatency);
     }
 }
 
@@ -900,6 +1257,7 @@ void CppParser::parseHardDefines()
     int oldIsSystemHeader = mIsSystemHeader;
     mIsSystemHeader = true;
     mParsing=true;
+    clearLookupCaches();
     {
         auto action = finally([&,this]{
             mParsing = false;
@@ -935,6 +1293,7 @@ void CppParser::resetParser()
             QMutexLocker locker(&mMutex);
             if (!mParsing && mLockCount ==0) {
                 mParsing = true;
+                clearLookupCaches();
                 break;
             }
         }
@@ -968,6 +1327,12 @@ void CppParser::resetParser()
         mFilesToScan.clear(); // list of base files to scan
         mNamespaces.clear();  // namespace and the statements in its scope
         mInlineNamespaces.clear();
+        mSystemHeaderCacheChecked = false;
+        mSystemHeaderModified = false;
+        mCachedSystemHeaders.clear();
+        mSystemHeaderIndex.reset();
+        mStringPool.clear();
+        mStringPoolPrunedSize = 0;
 
         mPreprocessor.clear();
         mTokenizer.clear();
@@ -1214,7 +1579,7 @@ PStatement CppParser::addStatement(const PStatement& parent,
         //find
         if (properties.testFlag(StatementProperty::spHasDefinition)) {
             PStatement oldStatement = findStatementInScope(newCommand,noNameArgs,kind,parent);
-            if (oldStatement  && !oldStatement->hasDefinition()) {
+            if (oldStatement  && !oldStatement->hasDefinition() && !oldStatement->isShared()) {
                 oldStatement->setHasDefinition(true);
                 if (oldStatement->fileName!=fileName) {
                     PFileIncludes fileIncludes=mPreprocessor.includesList().value(fileName);
@@ -1224,22 +1589,22 @@ PStatement CppParser::addStatement(const PStatement& parent,
                     }
                 }
                 oldStatement->definitionLine = line;
-                oldStatement->definitionFileName = fileName;
+                oldStatement->definitionFileName = internString(fileName);
                 return oldStatement;
             }
         }
     }
     PStatement result = std::make_shared<Statement>();
     result->parentScope = parent;
-    result->type = newType;
+    result->type = internString(newType);
     if (!newCommand.isEmpty())
-        result->command = newCommand;
+        result->command = internString(newCommand);
     else {
         mUniqId++;
         result->command = QString("__STATEMENT__%1").arg(mUniqId);
     }
     result->args = args;
-    result->noNameArgs = noNameArgs;
+    result->noNameArgs = internString(noNameArgs);
     result->value = value;
     result->kind = kind;
     result->scope = scope;
@@ -1247,8 +1612,8 @@ PStatement CppParser::addStatement(const PStatement& parent,
     result->properties = properties;
     result->line = line;
     result->definitionLine = line;
-    result->fileName = fileName;
-    result->definitionFileName = fileName;
+    result->fileName = internString(fileName);
+    result->definitionFileName = result->fileName;
     if (!fileName.isEmpty()) {
         result->setInProject(mIsProjectFile);
         result->setInSystemHeader(mIsSystemHeader);
@@ -1259,10 +1624,9 @@ PStatement CppParser::addStatement(const PStatement& parent,
     //result->children;
     //result->friends;
     if (scope == StatementScope::Local)
-        result->fullName =  newCommand;
+        result->fullName =  newCommand.isEmpty()?newCommand:result->command;
     else
         result->fullName =  getFullStatementName(newCommand, parent);
-    result->usageCount = -1;
     mStatementList.add(result);
     if (result->kind == StatementKind::skNamespace) {
         PStatementList namespaceList = mNamespaces.value(result->fullName,PStatementList());
@@ -1542,32 +1906,7 @@ QStringList CppParser::sortFilesByIncludeRelations(const QSet<QString> &files)
         mPreprocessor.clearTempResults();
     }
 
-    QSet<QString> fileSet=files;
-    while (!fileSet.isEmpty()) {
-        bool found=false;
-        foreach (const QString& file,fileSet) {
-            PFileIncludes fileIncludes = mPreprocessor.includesList().value(file);
-            bool hasInclude=false;
-            foreach(const QString& inc,fileIncludes->includeFiles.keys()) {
-                if (fileSet.contains(inc)) {
-                    hasInclude=true;
-                    break;
-                }
-            }
-            if (!hasInclude) {
-                result.push_front(file);
-                fileSet.remove(file);
-                found=true;
-                break;
-            }
-        }
-        if (!found) {
-            foreach (const QString& file,fileSet) {
-                result.push_front(file);
-                fileSet.remove(file);
-            }
-        }
-    }
+    result = mPreprocessor.includeGraph().sortByIncludeRelations(files);
     QSet<QString> newScannedFiles = mPreprocessor.scannedFiles();
     foreach(const QString& file, newScannedFiles) {
         if (!saveScannedFiles.contains(file))
@@ -3807,10 +4146,6 @@ void CppParser::internalParse(const QString &fileName)
 //    if (!isCfile(fileName) && !isHfile(fileName))  // support only known C/C++ files
 //        return;
 
-    // Preprocess the file...
-    auto action = finally([this]{
-        mTokenizer.clear();
-    });
     // Let the preprocessor augment the include records
     mPreprocessor.setScanOptions(mParseGlobalHeaders, mParseLocalHeaders);
     mPreprocessor.preprocess(fileName);
@@ -3828,11 +4163,82 @@ void CppParser::internalParse(const QString &fileName)
     mTokenizer.tokenize(preprocessResult);
     //reduce memory usage
     preprocessResult.clear();
-    if (mTokenizer.tokenCount() == 0)
-        return;
 #ifdef QT_DEBUG
 //        mTokenizer.dumpTokens(QString("r:\\tokens-%1.txt").arg(extractFileName(fileName)));
 #endif
+    handleTokens();
+}
+
+namespace {
+class CppTokenizeTask: public QRunnable {
+public:
+    explicit CppTokenizeTask(const QStringList& buffer):
+        mBuffer(buffer) {
+        setAutoDelete(false);
+    }
+    void run() override {
+        mTokenizer.tokenize(mBuffer);
+        mBuffer.clear();
+        mDone.release();
+    }
+    void waitForDone() {
+        mDone.acquire();
+    }
+    CppTokenizer& tokenizer() {
+        return mTokenizer;
+    }
+private:
+    QStringList mBuffer;
+    CppTokenizer mTokenizer;
+    QSemaphore mDone;
+};
+}
+
+void CppParser::internalParseFiles(const QStringList &files)
+{
+    if (!mEnabled)
+        return;
+    //Files must be preprocessed in order, because a header is only scanned by the first file including it.
+    //Tokenizing is independent, so it runs in the thread pool while statements of previous files are built.
+    QThreadPool* pool = QThreadPool::globalInstance();
+    int maxPendingTasks = std::max(1,QThread::idealThreadCount());
+    QQueue<std::shared_ptr<CppTokenizeTask>> tasks;
+    int next = 0;
+    while (next<files.count() || !tasks.isEmpty()) {
+        while (next<files.count() && tasks.count()<maxPendingTasks) {
+            const QString& file = files[next];
+            next++;
+            mFilesScannedCount++;
+            emit onProgress(file,mFilesToScanCount,mFilesScannedCount);
+            if (mPreprocessor.scannedFiles().contains(file))
+                continue;
+            mPreprocessor.setScanOptions(mParseGlobalHeaders, mParseLocalHeaders);
+            mPreprocessor.preprocess(file);
+            std::shared_ptr<CppTokenizeTask> task = std::make_shared<CppTokenizeTask>(mPreprocessor.result());
+            //reduce memory usage
+            mPreprocessor.clearTempResults();
+            pool->start(task.get());
+            tasks.enqueue(task);
+        }
+        if (tasks.isEmpty())
+            continue;
+        std::shared_ptr<CppTokenizeTask> task = tasks.dequeue();
+        //not started yet, run it here instead of waiting
+        if (pool->tryTake(task.get()))
+            task->run();
+        task->waitForDone();
+        mTokenizer.swap(task->tokenizer());
+        handleTokens();
+    }
+}
+
+void CppParser::handleTokens()
+{
+    auto action = finally([this]{
+        mTokenizer.clear();
+    });
+    if (mTokenizer.tokenCount() == 0)
+        return;
 #ifdef QT_DEBUG
         mLastIndex = -1;
 #endif
@@ -3859,7 +4265,7 @@ void CppParser::inheritClassStatement(const PStatement& derived, bool isStruct,
         else
             access = StatementClassScope::Private;
     }
-    foreach (const PStatement& statement, base->children) {
+    foreach (const PStatement& statement, mStatementList.childrenStatements(base)) {
         if (statement->classScope == StatementClassScope::Private
                 || statement->kind == StatementKind::skConstructor
                 || statement->kind == StatementKind::skDestructor)
@@ -3923,10 +4329,7 @@ QList<PStatement> CppParser::getListOfFunctions(const QString &fileName, int lin
 
 PStatement CppParser::findMacro(const QString &phrase, const QString &fileName)
 {
-    const StatementMap& statementMap =mStatementList.childrenStatements(nullptr);
-    if (statementMap.isEmpty())
-        return PStatement();
-    StatementList statements = statementMap.values(phrase);
+    StatementList statements = mStatementList.childrenStatementsNamed(PStatement(), phrase);
     PFileIncludes includes = mPreprocessor.includesList().value(fileName,PFileIncludes());
     foreach (const PStatement& s, statements) {
         if (s->kind == StatementKind::skPreprocessor) {
@@ -3942,50 +4345,23 @@ PStatement CppParser::findMacro(const QString &phrase, const QString &fileName)
 PStatement CppParser::findMemberOfStatement(const QString &phrase,
                                             const PStatement& scopeStatement)
 {
-    const StatementMap& statementMap =mStatementList.childrenStatements(scopeStatement);
-    if (statementMap.isEmpty())
+    QString s = memberNameOf(phrase);
+    if (!mStatementList.containsName(s))
         return PStatement();
 
-    QString s = phrase;
-    //remove []
-    int p = phrase.indexOf('[');
-    if (p>=0)
-        s.truncate(p);
-    //remove ()
-    p = phrase.indexOf('(');
-    if (p>=0)
-        s.truncate(p);
-
-    //remove <>
-    p =s.indexOf('<');
-    if (p>=0)
-        s.truncate(p);
-
-    return statementMap.value(s,PStatement());
+    StatementList statements = mStatementList.childrenStatementsNamed(scopeStatement, s);
+    if (statements.isEmpty())
+        return PStatement();
+    return statements.front();
 }
 
 QList<PStatement> CppParser::findMembersOfStatement(const QString &phrase, const PStatement &scopeStatement)
 {
-    const StatementMap& statementMap =mStatementList.childrenStatements(scopeStatement);
-    if (statementMap.isEmpty())
+    QString s = memberNameOf(phrase);
+    if (!mStatementList.containsName(s))
         return QList<PStatement>();
 
-    QString s = phrase;
-    //remove []
-    int p = phrase.indexOf('[');
-    if (p>=0)
-        s.truncate(p);
-    //remove ()
-    p = phrase.indexOf('(');
-    if (p>=0)
-        s.truncate(p);
-
-    //remove <>
-    p =s.indexOf('<');
-    if (p>=0)
-        s.truncate(p);
-
-    return statementMap.values(s);
+    return mStatementList.childrenStatementsNamed(scopeStatement, s);
 }
 
 PStatement CppParser::findStatementInScope(const QString &name, const QString &noNameArgs,
@@ -4998,9 +5374,7 @@ PStatement CppParser::doFindStatementInScope(const QString &name,
                                              StatementKind kind,
                                              const PStatement& scope)
 {
-    const StatementMap& statementMap =mStatementList.childrenStatements(scope);
-
-    foreach (const PStatement& statement, statementMap.values(name)) {
+    foreach (const PStatement& statement, mStatementList.childrenStatementsNamed(scope, name)) {
         if (statement->kind == kind && statement->noNameArgs == noNameArgs) {
             return statement;
         }
@@ -5013,6 +5387,11 @@ void CppParser::internalInvalidateFile(const QString &fileName)
     if (fileName.isEmpty())
         return;
 
+    if (mSystemHeaderIndex && mSystemHeaderIndex->files.contains(fileName))
+        detachSystemHeaderIndex();
+    if (::isSystemHeaderFile(fileName,mPreprocessor.includePaths()))
+        mSystemHeaderModified = true;
+
     // remove its include files list
     PFileIncludes p = findFileIncludes(fileName, true);
     if (p) {
@@ -5048,6 +5427,10 @@ void CppParser::internalInvalidateFile(const QString &fileName)
 
     // delete it from scannedfiles
     mPreprocessor.removeScannedFile(fileName);
+
+    //identifiers of the removed statements (like the ones typed while editing) are not used anymore
+    if (mStringPool.count() > mStringPoolPrunedSize + STRING_POOL_PRUNE_GROWTH)
+        pruneStringPool();
 }
 
 void CppParser::internalInvalidateFiles(const QSet<QString> &files)
@@ -5062,11 +5445,9 @@ QSet<QString> CppParser::calculateFilesToBeReparsed(const QString &fileName)
         return QSet<QString>();
     QSet<QString> result;
     result.insert(fileName);
-    foreach (const QString& file, mProjectFiles) {
-        PFileIncludes fileIncludes = mPreprocessor.includesList().value(file,PFileIncludes());
-        if (fileIncludes && fileIncludes->includeFiles.contains(fileName)) {
+    foreach (const QString& file, mPreprocessor.includeGraph().dependents(fileName)) {
+        if (mProjectFiles.contains(file))
             result.insert(file);
-        }
     }
     return result;
 }
@@ -5691,6 +6072,460 @@ QList<QString> CppParser::namespaces()
     return mNamespaces.keys();
 }
 
+QString CppParser::internString(const QString &s)
+{
+    if (s.isEmpty())
+        return s;
+    QSet<QString>::const_iterator it = mStringPool.constFind(s);
+    if (it == mStringPool.constEnd())
+        it = mStringPool.insert(s);
+    return *it;
+}
+
+void CppParser::pruneStringPool()
+{
+    QSet<QString>::iterator it = mStringPool.begin();
+    while (it != mStringPool.end()) {
+        //only referenced by the pool
+        if (it->isDetached())
+            it = mStringPool.erase(it);
+        else
+            ++it;
+    }
+    mStringPoolPrunedSize = mStringPool.count();
+}
+
+const QString &CppParser::systemHeaderCacheDir() const
+{
+    return mSystemHeaderCacheDir;
+}
+
+void CppParser::setSystemHeaderCacheDir(const QString &newSystemHeaderCacheDir)
+{
+    mSystemHeaderCacheDir = newSystemHeaderCacheDir;
+}
+
+QString CppParser::systemHeaderCacheFile() const
+{
+    if (mSystemHeaderCacheDir.isEmpty())
+        return QString();
+    //parse results of system headers depend on the language, include paths and predefined macros
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(SYSTEM_HEADER_CACHE_VERSION));
+    hash.addData(QByteArray::number((int)mLanguage));
+    foreach (const QString& path, mPreprocessor.includePathList()) {
+        hash.addData((path+"\n").toUtf8());
+    }
+    QStringList defines;
+    foreach (const PDefine& define, mPreprocessor.hardDefines()) {
+        defines.append(define->name+define->args+" "+define->value);
+    }
+    defines.sort();
+    hash.addData(defines.join("\n").toUtf8());
+    return includeTrailingPathDelimiter(mSystemHeaderCacheDir)
+            + QString::fromLatin1(hash.result().toHex())
+            + ".cache";
+}
+
+//collect statements parent first, so the parent id of a statement is always smaller than its own
+static void collectStatementsInFiles(const StatementModel& model,
+                                     const StatementMap& statements,
+                                     const QSet<QString>& files,
+                                     QVector<PStatement>& result,
+                                     QHash<const Statement*,qint32>& ids)
+{
+    foreach (const PStatement& statement, statements) {
+        if (!files.contains(statement->fileName))
+            continue;
+        //parent is not saved, drop it instead of making it a global
+        PStatement parent = statement->parentScope.lock();
+        if (parent && !ids.contains(parent.get()))
+            continue;
+        ids.insert(statement.get(),result.count());
+        result.append(statement);
+        //children added to shared statements are only in the model
+        collectStatementsInFiles(model,model.childrenStatements(statement),files,result,ids);
+    }
+}
+
+static void writeStatementMap(QDataStream& out,
+                              const StatementMap& statements,
+                              const QHash<const Statement*,qint32>& ids)
+{
+    QVector<qint32> statementIds;
+    QStringList keys;
+    for (auto it=statements.begin();it!=statements.end();++it) {
+        qint32 id = ids.value(it.value().get(),-1);
+        if (id<0)
+            continue;
+        keys.append(it.key());
+        statementIds.append(id);
+    }
+    out<<(qint32)keys.count();
+    for (int i=0;i<keys.count();i++) {
+        out<<keys[i]<<statementIds[i];
+    }
+}
+
+static bool readStatementMap(QDataStream& in,
+                             const StatementList& statements,
+                             StatementMap& result)
+{
+    qint32 count;
+    in>>count;
+    for (int i=0;i<count && in.status()==QDataStream::Ok;i++) {
+        QString key;
+        qint32 id;
+        in>>key>>id;
+        if (id<0 || id>=statements.count())
+            return false;
+        result.insert(key,statements[id]);
+    }
+    return in.status()==QDataStream::Ok;
+}
+
+static PSystemHeaderIndex readSystemHeaderIndex(const QString& cacheFile)
+{
+    QFile file(cacheFile);
+    if (!file.open(QFile::ReadOnly))
+        return PSystemHeaderIndex();
+    QByteArray buffer;
+    uchar* data = file.map(0,file.size());
+    if (data)
+        buffer = QByteArray::fromRawData((const char*)data,file.size());
+    else
+        buffer = file.readAll();
+    QDataStream in(buffer);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic;
+    qint32 version;
+    in>>magic>>version;
+    if (in.status()!=QDataStream::Ok
+            || magic!=SYSTEM_HEADER_CACHE_MAGIC
+            || version!=SYSTEM_HEADER_CACHE_VERSION)
+        return PSystemHeaderIndex();
+
+    std::shared_ptr<SystemHeaderIndex> index = std::make_shared<SystemHeaderIndex>();
+    qint32 uniqId;
+    qint32 count;
+    in>>uniqId>>count;
+    index->uniqId = uniqId;
+    QStringList files;
+    for (int i=0;i<count && in.status()==QDataStream::Ok;i++) {
+        QString fileName;
+        qint64 lastModified;
+        qint64 size;
+        in>>fileName>>lastModified>>size;
+        QFileInfo info(fileName);
+        //header changed since the cache is saved
+        if (!info.exists()
+                || info.lastModified().toMSecsSinceEpoch()!=lastModified
+                || info.size()!=size)
+            return PSystemHeaderIndex();
+        files.append(fileName);
+        index->files.insert(fileName);
+    }
+
+    //statements are saved parent first
+    in>>count;
+    StatementList& statements = index->statements;
+    QSet<QString> stringPool;
+    auto internString=[&stringPool](QString& s) {
+        QSet<QString>::const_iterator it = stringPool.constFind(s);
+        if (it == stringPool.constEnd())
+            stringPool.insert(s);
+        else
+            s = *it;
+    };
+    for (int i=0;i<count && in.status()==QDataStream::Ok;i++) {
+        qint32 parentId, kind, scope, classScope, line, definitionLine;
+        qint32 fileId, definitionFileId, properties;
+        PStatement statement = std::make_shared<Statement>();
+        in>>parentId>>statement->type>>statement->command>>statement->args
+                >>statement->noNameArgs>>statement->value
+                >>kind>>scope>>classScope>>line>>definitionLine
+                >>fileId>>definitionFileId
+                >>statement->friends>>statement->fullName>>statement->usingList
+                >>properties;
+        if (parentId>=i
+                || fileId<0 || fileId>=files.count()
+                || definitionFileId<0 || definitionFileId>=files.count())
+            return PSystemHeaderIndex();
+        internString(statement->type);
+        internString(statement->command);
+        internString(statement->noNameArgs);
+        if (parentId>=0) {
+            statement->parentScope = statements[parentId];
+            statements[parentId]->children.insert(statement->command,statement);
+        }
+        statement->kind = static_cast<StatementKind>(kind);
+        statement->scope = static_cast<StatementScope>(scope);
+        statement->classScope = static_cast<StatementClassScope>(classScope);
+        statement->line = line;
+        statement->definitionLine = definitionLine;
+        statement->fileName = files[fileId];
+        statement->definitionFileName = files[definitionFileId];
+        statement->properties = StatementProperties(QFlag(properties));
+        statement->properties.setFlag(StatementProperty::spShared);
+        statements.append(statement);
+    }
+
+    in>>count;
+    for (int i=0;i<count && in.status()==QDataStream::Ok;i++) {
+        PFileIncludes fileIncludes = std::make_shared<FileIncludes>();
+        qint32 fileId;
+        in>>fileId>>fileIncludes->includeFiles>>fileIncludes->directIncludes>>fileIncludes->usings;
+        if (fileId<0 || fileId>=files.count())
+            return PSystemHeaderIndex();
+        fileIncludes->baseFile = files[fileId];
+        if (!readStatementMap(in,statements,fileIncludes->statements))
+            return PSystemHeaderIndex();
+        if (!readStatementMap(in,statements,fileIncludes->declaredStatements))
+            return PSystemHeaderIndex();
+        qint32 scopeCount;
+        in>>scopeCount;
+        for (int j=0;j<scopeCount && in.status()==QDataStream::Ok;j++) {
+            qint32 startLine, id;
+            in>>startLine>>id;
+            if (id<0 || id>=statements.count())
+                return PSystemHeaderIndex();
+            fileIncludes->scopes.addScope(startLine,statements[id]);
+        }
+        qint32 defineCount;
+        in>>defineCount;
+        PDefineMap defines;
+        if (defineCount>0)
+            defines = std::make_shared<DefineMap>();
+        for (int j=0;j<defineCount && in.status()==QDataStream::Ok;j++) {
+            PDefine define = std::make_shared<Define>();
+            in>>define->name>>define->args>>define->value>>define->filename
+                    >>define->hardCoded>>define->argList>>define->argUsed
+                    >>define->formatValue;
+            defines->insert(define->name,define);
+        }
+        index->includesList.append(fileIncludes);
+        index->definesList.append(defines);
+    }
+    QStringList inlineNamespaces;
+    in>>inlineNamespaces;
+    if (in.status()!=QDataStream::Ok)
+        return PSystemHeaderIndex();
+    foreach (const QString& name, inlineNamespaces) {
+        index->inlineNamespaces.insert(name);
+    }
+    return index;
+}
+
+//indexes loaded by parsers, shared by all parsers with the same cache key
+static QMutex systemHeaderIndexesMutex;
+static QHash<QString,std::weak_ptr<const SystemHeaderIndex>> systemHeaderIndexes;
+
+bool CppParser::loadSystemHeaderCache()
+{
+    //only load into a fresh parser
+    if (!mParseGlobalHeaders || !mPreprocessor.scannedFiles().isEmpty())
+        return false;
+    QString cacheFile = systemHeaderCacheFile();
+    if (cacheFile.isEmpty())
+        return false;
+    PSystemHeaderIndex index;
+    {
+        QMutexLocker locker(&systemHeaderIndexesMutex);
+        index = systemHeaderIndexes.value(cacheFile).lock();
+        if (!index) {
+            index = readSystemHeaderIndex(cacheFile);
+            if (!index)
+                return false;
+            systemHeaderIndexes.insert(cacheFile,index);
+        }
+    }
+
+    //statements of the index are not copied, only the global ones are linked into our statement list
+    foreach (const PStatement& statement, index->statements) {
+        if (!statement->parentScope.lock())
+            mStatementList.add(statement);
+        if (statement->kind == StatementKind::skNamespace) {
+            PStatementList namespaceList = mNamespaces.value(statement->fullName,PStatementList());
+            if (!namespaceList) {
+                namespaceList=std::make_shared<StatementList>();
+                mNamespaces.insert(statement->fullName,namespaceList);
+            }
+            namespaceList->append(statement);
+        }
+    }
+    for (int i=0;i<index->includesList.count();i++) {
+        mPreprocessor.addScannedFile(index->includesList[i],index->definesList[i]);
+    }
+    mInlineNamespaces.unite(index->inlineNamespaces);
+    mUniqId = std::max(mUniqId,index->uniqId);
+    mCachedSystemHeaders = index->files;
+    mSystemHeaderIndex = index;
+    return true;
+}
+
+void CppParser::detachSystemHeaderIndex()
+{
+    if (!mSystemHeaderIndex)
+        return;
+    foreach (const PStatement& statement, mSystemHeaderIndex->statements) {
+        if (!statement->parentScope.lock())
+            mStatementList.deleteStatement(statement);
+    }
+    const QList<QString>& keys=mNamespaces.keys();
+    for (const QString& key:keys) {
+        PStatementList statements = mNamespaces.value(key);
+        for (int i=statements->size()-1;i>=0;i--) {
+            if (statements->at(i)->isShared())
+                statements->removeAt(i);
+        }
+        if (statements->isEmpty())
+            mNamespaces.remove(key);
+    }
+    //files using the shared headers lose their symbols, so they must be parsed again
+    QStringList affectedFiles;
+    foreach (const QString& fileName, mPreprocessor.scannedFiles()) {
+        if (mSystemHeaderIndex->files.contains(fileName)
+                || ::isSystemHeaderFile(fileName,mPreprocessor.includePaths()))
+            continue;
+        PFileIncludes fileIncludes = mPreprocessor.includesList().value(fileName);
+        if (!fileIncludes)
+            continue;
+        for (QMap<QString,bool>::const_iterator it = fileIncludes->includeFiles.constBegin();
+             it != fileIncludes->includeFiles.constEnd(); ++it) {
+            if (mSystemHeaderIndex->files.contains(it.key())) {
+                affectedFiles.append(fileName);
+                break;
+            }
+        }
+    }
+    foreach (const QString& fileName, mSystemHeaderIndex->files) {
+        mPreprocessor.removeScannedFile(fileName);
+    }
+    mCachedSystemHeaders.clear();
+    mSystemHeaderIndex.reset();
+    foreach (const QString& fileName, affectedFiles) {
+        queueParseFile(fileName, mProjectFiles.contains(fileName), false, false);
+    }
+}
+
+void CppParser::saveSystemHeaderCache()
+{
+    if (!mParseGlobalHeaders || mSystemHeaderModified)
+        return;
+    QString cacheFile = systemHeaderCacheFile();
+    if (cacheFile.isEmpty())
+        return;
+    QSet<QString> headers;
+    bool changed = false;
+    foreach (const QString& fileName, mPreprocessor.scannedFiles()) {
+        if (::isSystemHeaderFile(fileName,mPreprocessor.includePaths())) {
+            headers.insert(fileName);
+            if (!mCachedSystemHeaders.contains(fileName))
+                changed = true;
+        }
+    }
+    if (!changed)
+        return;
+
+    QVector<PStatement> statements;
+    QHash<const Statement*,qint32> ids;
+    collectStatementsInFiles(mStatementList,mStatementList.childrenStatements(),headers,statements,ids);
+
+    QStringList files;
+    QHash<QString,qint32> fileIds;
+    foreach (const QString& fileName, headers) {
+        fileIds.insert(fileName,files.count());
+        files.append(fileName);
+    }
+
+    QDir().mkpath(mSystemHeaderCacheDir);
+    QSaveFile file(cacheFile);
+    if (!file.open(QFile::WriteOnly))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out<<(quint32)SYSTEM_HEADER_CACHE_MAGIC<<(qint32)SYSTEM_HEADER_CACHE_VERSION;
+    out<<(qint32)mUniqId<<(qint32)files.count();
+    foreach (const QString& fileName, files) {
+        QFileInfo info(fileName);
+        out<<fileName<<(qint64)info.lastModified().toMSecsSinceEpoch()<<(qint64)info.size();
+    }
+
+    out<<(qint32)statements.count();
+    foreach (const PStatement& statement, statements) {
+        PStatement parent = statement->parentScope.lock();
+        qint32 parentId = parent?ids.value(parent.get(),-1):-1;
+        StatementProperties properties = statement->properties;
+        int definitionLine = statement->definitionLine;
+        qint32 definitionFileId = fileIds.value(statement->definitionFileName,-1);
+        //definition is in a user file, only keep the declaration
+        if (definitionFileId<0) {
+            definitionFileId = fileIds.value(statement->fileName);
+            definitionLine = statement->line;
+            properties.setFlag(StatementProperty::spHasDefinition,false);
+        }
+        out<<parentId<<statement->type<<statement->command<<statement->args
+          <<statement->noNameArgs<<statement->value
+          <<(qint32)statement->kind<<(qint32)statement->scope<<(qint32)statement->classScope
+          <<(qint32)statement->line<<(qint32)definitionLine
+          <<fileIds.value(statement->fileName)<<definitionFileId
+          <<statement->friends<<statement->fullName<<statement->usingList
+          <<(qint32)properties;
+    }
+
+    QList<PFileIncludes> includesList;
+    foreach (const QString& fileName, files) {
+        PFileIncludes fileIncludes = mPreprocessor.includesList().value(fileName);
+        if (fileIncludes)
+            includesList.append(fileIncludes);
+    }
+    out<<(qint32)includesList.count();
+    foreach (const PFileIncludes& fileIncludes, includesList) {
+        out<<fileIds.value(fileIncludes->baseFile)<<fileIncludes->includeFiles
+          <<fileIncludes->directIncludes<<fileIncludes->usings;
+        writeStatementMap(out,fileIncludes->statements,ids);
+        writeStatementMap(out,fileIncludes->declaredStatements,ids);
+        QVector<PCppScope> scopes;
+        foreach (const PCppScope& scope, fileIncludes->scopes.scopes()) {
+            if (ids.contains(scope->statement.get()))
+                scopes.append(scope);
+        }
+        out<<(qint32)scopes.count();
+        foreach (const PCppScope& scope, scopes) {
+            out<<(qint32)scope->startLine<<ids.value(scope->statement.get());
+        }
+        PDefineMap defines = mPreprocessor.fileDefines(fileIncludes->baseFile);
+        out<<(qint32)(defines?defines->count():0);
+        if (defines) {
+            foreach (const PDefine& define, *defines) {
+                out<<define->name<<define->args<<define->value<<define->filename
+                  <<define->hardCoded<<define->argList<<define->argUsed
+                  <<define->formatValue;
+            }
+        }
+    }
+
+    QStringList inlineNamespaces;
+    foreach (const QString& name, mInlineNamespaces) {
+        PStatementList namespaceList = mNamespaces.value(name);
+        if (!namespaceList)
+            continue;
+        foreach (const PStatement& statement, *namespaceList) {
+            if (ids.contains(statement.get())) {
+                inlineNamespaces.append(name);
+                break;
+            }
+        }
+    }
+    out<<inlineNamespaces;
+    if (out.status()==QDataStream::Ok && file.commit()) {
+        mCachedSystemHeaders = headers;
+        //let new parsers load the larger cache
+        QMutexLocker locker(&systemHeaderIndexesMutex);
+        systemHeaderIndexes.remove(cacheFile);
+    }
+}
+
 ParserLanguage CppParser::language() const
 {
     return mLanguage;
@@ -5778,45 +6613,15 @@ void CppParser::setEnabled(bool newEnabled)
     }
 }
 
-CppFileParserThread::CppFileParserThread(
-        PCppParser parser,
-        QString fileName,
-        bool inProject,
-        bool onlyIfNotParsed,
-        bool updateView,
-        QObject *parent):QThread(parent),
-    mParser(parser),
-    mFileName(fileName),
-    mInProject(inProject),
-    mOnlyIfNotParsed(onlyIfNotParsed),
-    mUpdateView(updateView)
-{
-    connect(this,&QThread::finished,
-            this,&QObject::deleteLater);
-}
-
-void CppFileParserThread::run()
-{
-    if (mParser && !mParser->parsing()) {
-        mParser->parseFile(mFileName,mInProject,mOnlyIfNotParsed,mUpdateView);
-    }
-}
-
-CppFileListParserThread::CppFileListParserThread(PCppParser parser,
-                                                 bool updateView, QObject *parent):
+CppParserWorker::CppParserWorker(CppParser *parser, QObject *parent):
     QThread(parent),
-    mParser(parser),
-    mUpdateView(updateView)
+    mParser(parser)
 {
-    connect(this,&QThread::finished,
-            this,&QObject::deleteLater);
 }
 
-void CppFileListParserThread::run()
+void CppParserWorker::run()
 {
-    if (mParser && !mParser->parsing()) {
-        mParser->parseFileList(mUpdateView);
-    }
+    mParser->processParseRequests();
 }
 
 void parseFile(PCppParser parser, const QString& fileName, bool inProject, bool onlyIfNotParsed, bool updateView)
@@ -5825,13 +6630,7 @@ void parseFile(PCppParser parser, const QString& fileName, bool inProject, bool
         return;
     if (!parser->enabled())
         return;
-    //delete when finished
-    CppFileParserThread* thread = new CppFileParserThread(parser,fileName,inProject,onlyIfNotParsed,updateView);
-    thread->connect(thread,
-                    &QThread::finished,
-                    thread,
-                    &QThread::deleteLater);
-    thread->start();
+    parser->queueParseFile(fileName,inProject,onlyIfNotParsed,updateView);
 }
 
 void parseFileList(PCppParser parser, bool updateView)
@@ -5840,11 +6639,5 @@ void parseFileList(PCppParser parser, bool updateView)
         return;
     if (!parser->enabled())
         return;
-    //delete when finished
-    CppFileListParserThread *thread = new CppFileListParserThread(parser,updateView);
-    thread->connect(thread,
-                    &QThread::finished,
-                    thread,
-                    &QThread::deleteLater);
-    thread->start();
+    parser->queueParseFileList(updateView);
 }
@@ -17,14 +17,39 @@
 #ifndef CPPPARSER_H
 #define CPPPARSER_H
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QObject>
 #include <QThread>
 #include <QVector>
+#include <QWaitCondition>
 #include "statementmodel.h"
 #include "cpptokenizer.h"
 #include "cpppreprocessor.h"
 
+//parse results of system headers loaded from the cache,
+//shared by all parsers using the same include paths and hard defines
+struct SystemHeaderIndex {
+    QSet<QString> files;
+    StatementList statements; // parent first
+    QList<PFileIncludes> includesList;
+    QList<PDefineMap> definesList;
+    QSet<QString> inlineNamespaces;
+    int uniqId;
+};
+using PSystemHeaderIndex = std::shared_ptr<const SystemHeaderIndex>;
+
+struct ParseRequest {
+    QString fileName; // empty for parsing the file list
+    bool inProject;
+    bool onlyIfNotParsed;
+    bool updateView;
+    QElapsedTimer timer; // started when the request is queued
+};
+using PParseRequest = std::shared_ptr<ParseRequest>;
+
+class CppParserWorker;
+
 class CppParser : public QObject
 {
     Q_OBJECT
@@ -107,9 +132,24 @@ public:
     bool isIncludeNextLine(const QString &line);
     bool isProjectHeaderFile(const QString& fileName);
     bool isSystemHeaderFile(const QString& fileName);
-    void parseFile(const QString& fileName, bool inProject,
+    // return false if the parser is busy or frozen and nothing is parsed
+    bool parseFile(const QString& fileName, bool inProject,
+                   bool onlyIfNotParsed = false, bool updateView = true);
+    bool parseFileList(bool updateView = true);
+    // parse in the parser's worker thread, pending requests for the same file are merged
+    void queueParseFile(const QString& fileName, bool inProject,
                    bool onlyIfNotParsed = false, bool updateView = true);
-    void parseFileList(bool updateView = true);
+    void queueParseFileList(bool updateView = true);
+    // wait until all queued requests are parsed; return false on timeout
+    bool waitForParseQueue(int msecs);
+    // reparse only the function body containing the edited lines [firstLine,lastLine] (line numbers after the edit),
+    // lineDelta is the count of lines inserted (positive) or deleted (negative) by the edit.
+    // return false if the edit is not inside a single function body, and the file must be fully reparsed
+    bool parseFunctionBody(const QString& fileName, int firstLine, int lastLine, int lineDelta);
+    int parseQueueDepth();
+    int parsedRequestCount();
+    qint64 lastParseLatency(); // ms from queued to parsed
+    qint64 maxParseLatency();
     void parseHardDefines();
     bool parsing() const;
     void resetParser();
@@ -150,12 +190,26 @@ public:
 
     QList<QString> namespaces();
 
+    const QString &systemHeaderCacheDir() const;
+    void setSystemHeaderCacheDir(const QString &newSystemHeaderCacheDir);
+
 signals:
     void onProgress(const QString& fileName, int total, int current);
     void onBusy();
     void onStartParsing();
     void onEndParsing(int total, int updateView);
 private:
+    void queueParseRequest(const QString& fileName, bool inProject,
+                           bool onlyIfNotParsed, bool updateView);
+    void processParseRequests();
+
+    QString internString(const QString& s);
+    void pruneStringPool();
+    QString systemHeaderCacheFile() const;
+    bool loadSystemHeaderCache();
+    void saveSystemHeaderCache();
+    void detachSystemHeaderIndex();
+
     PStatement addInheritedStatement(
             const PStatement& derived,
             const PStatement& inherit,
@@ -258,6 +312,21 @@ private:
             const QString& name,
             const QString& namespaceName);
 
+    PStatement internalFindStatementOf(const QString& fileName,
+                                       const QString& phrase,
+                                       const PStatement& currentScope,
+                                       PStatement& parentScopeType);
+    PStatement internalFindStatementOf(const QString& fileName,
+                                       const QStringList& expression,
+                                       const PStatement& currentScope);
+    QString lookupCacheKey(const QString& fileName,
+                           const PStatement& scope,
+                           const QString& phrase) const;
+    void addToLookupCache(const QString& key,
+                          const PStatement& statement,
+                          const PStatement& parentScopeType);
+    void clearLookupCaches();
+
     //{Find statement starting from startScope}
     PStatement findStatementStartingFrom(const QString& fileName,
                                          const QString& phrase,
@@ -465,6 +534,9 @@ private:
     void handleUsing();
     void handleVar(const QString& typePrefix,bool isExtern,bool isStatic);
     void internalParse(const QString& fileName);
+    void internalParseFiles(const QStringList& files);
+    void handleTokens();
+    void removeStatementTree(const PStatement& statement, const PFileIncludes& fileIncludes);
 //    function FindMacroDefine(const Command: AnsiString): PStatement;
     void inheritClassStatement(
             const PStatement& derived,
@@ -666,6 +738,26 @@ private:
     bool mParsing;
     QHash<QString,PStatementList> mNamespaces;  // namespace and the statements in its scope
     QSet<QString> mInlineNamespaces;
+    QSet<QString> mStringPool; // shared copies of file names, types and identifiers
+    int mStringPoolPrunedSize; // size of the pool after it was last pruned
+    //results of findStatementOf and getFileUsings, cleared when parsing starts
+    QHash<QString,QPair<PStatement,PStatement>> mLookupCache;
+    QHash<QString,QSet<QString>> mFileUsingsCache;
+    QString mSystemHeaderCacheDir; // empty means don't cache parse results of system headers
+    bool mSystemHeaderCacheChecked;
+    QSet<QString> mCachedSystemHeaders; // system headers already in the cache file
+    bool mSystemHeaderModified; // a system header is reparsed, maybe from an unsaved editor
+    PSystemHeaderIndex mSystemHeaderIndex;
+
+    QMutex mParseQueueMutex;
+    QWaitCondition mParseQueueCondition;
+    QList<PParseRequest> mParseQueue;
+    CppParserWorker* mParseWorker;
+    bool mQuitParseWorker;
+    bool mProcessingParseRequest;
+    int mParsedRequestCount;
+    qint64 mLastParseLatency;
+    qint64 mMaxParseLatency;
 #ifdef QT_DEBUG
     int mLastIndex;
 #endif
@@ -676,47 +768,23 @@ private:
 #endif
     QMap<QString,KeywordType> mCppKeywords;
     QSet<QString> mCppTypeKeywords;
+
+    friend class CppParserWorker;
 };
 using PCppParser = std::shared_ptr<CppParser>;
 
-class CppFileParserThread : public QThread {
+class CppParserWorker : public QThread {
     Q_OBJECT
 public:
-    explicit CppFileParserThread(
-            PCppParser parser,
-            QString fileName,
-            bool inProject,
-            bool onlyIfNotParsed = false,
-            bool updateView = true,
-            QObject *parent = nullptr);
+    explicit CppParserWorker(CppParser* parser, QObject *parent = nullptr);
 
 private:
-    PCppParser mParser;
-    QString mFileName;
-    bool mInProject;
-    bool mOnlyIfNotParsed;
-    bool mUpdateView;
+    CppParser* mParser;
 
     // QThread interface
 protected:
     void run() override;
 };
-using PCppParserThread = std::shared_ptr<CppFileParserThread>;
-
-class CppFileListParserThread: public QThread {
-    Q_OBJECT
-public:
-    explicit CppFileListParserThread(
-            PCppParser parser,
-            bool updateView = true,
-            QObject *parent = nullptr);
-private:
-    PCppParser mParser;
-    bool mUpdateView;
-    // QThread interface
-protected:
-    void run() override;
-};
 
 void parseFile(
     PCppParser parser,
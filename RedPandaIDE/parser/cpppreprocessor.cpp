@@ -18,11 +18,31 @@
 #include "../utils.h"
 
 #include <QFile>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
 #include <QTextCodec>
 #include <QDebug>
 #include <QMessageBox>
 
-CppPreprocessor::CppPreprocessor()
+//the header cache is dropped when it holds more chars than this
+#define MAX_CACHED_HEADER_CHARS (32*1024*1024)
+
+struct CachedHeader {
+    QDateTime lastModified;
+    qint64 size;
+    QStringList buffer; // comments removed
+    QString includeGuard; // empty if the file is not wrapped by an include guard
+};
+using PCachedHeader = std::shared_ptr<const CachedHeader>;
+
+//system headers read by all preprocessors
+static QMutex cachedHeadersMutex;
+static QHash<QString,PCachedHeader> cachedHeaders;
+static qint64 cachedHeaderChars = 0;
+
+CppPreprocessor::CppPreprocessor():
+    mExpandDepthReached(false)
 {
 }
 
@@ -36,6 +56,7 @@ void CppPreprocessor::clear()
     mIncludesList.clear();
     mFileDefines.clear(); //dictionary to save defines for each headerfile;
     mScannedFiles.clear();
+    mIncludeGraph.clear();
 
     //option data for the parser
     //{ List of current project's include path }
@@ -58,6 +79,7 @@ void CppPreprocessor::clearTempResults()
     mIncludes.clear(); // stack of files we've stepped into. last one is current file, first one is source file
     mBranchResults.clear();// stack of branch results (boolean). last one is current branch, first one is outermost branch
     mDefines.clear(); // working set, editable
+    invalidateExpansions();
     mProcessed.clear(); // dictionary to save filename already processed
 }
 
@@ -84,6 +106,7 @@ void CppPreprocessor::addDefineByParts(const QString &name, const QString &args,
         }
         defineMap->insert(define->name,define);
         mDefines.insert(name,define);
+        invalidateExpansions();
     }
 }
 
@@ -160,6 +183,7 @@ void CppPreprocessor::preprocess(const QString &fileName)
     clearTempResults();
     mFileName = fileName;
     mDefines = mHardDefines;
+    invalidateExpansions();
     openInclude(fileName);
     //    StringsToFile(mBuffer,"f:\\buffer.txt");
     preprocessBuffer();
@@ -167,6 +191,43 @@ void CppPreprocessor::preprocess(const QString &fileName)
     //    StringsToFile(mResult,"f:\\log.txt");
 }
 
+bool CppPreprocessor::preprocessLines(const QString &fileName, int startLine, int endLine, QStringList &result)
+{
+    result.clear();
+    if (!mScannedFiles.contains(fileName))
+        return false;
+    QStringList buffer;
+    if (!mOnGetFileStream || !mOnGetFileStream(fileName,buffer))
+        buffer = readFileToLines(fileName);
+    if (startLine<1 || startLine>endLine || endLine>buffer.count())
+        return false;
+    QStringList lines = buffer.mid(startLine-1, endLine-startLine+1);
+    //the lines are expanded with the defines at the end of the file, which are only the ones
+    //at startLine if no macro is defined after it or undefined anywhere
+    for (int i=0;i<buffer.count();i++) {
+        QString line = buffer[i].trimmed();
+        if (!line.startsWith('#'))
+            continue;
+        if (i>=startLine-1 && i<endLine)
+            return false;
+        line = line.mid(1).trimmed();
+        if (line.startsWith("undef"))
+            return false;
+        if (i>=endLine && line.startsWith("define"))
+            return false;
+    }
+    clearTempResults();
+    mFileName = fileName;
+    mDefines = mHardDefines;
+    invalidateExpansions();
+    addDefinesInFile(fileName);
+    foreach (const QString& line, removeComments(lines)) {
+        result.append(expandMacros(line,1));
+    }
+    clearTempResults();
+    return true;
+}
+
 void CppPreprocessor::invalidDefinesInFile(const QString &fileName)
 {
     PDefineMap defineMap = mFileDefines.value(fileName,PDefineMap());
@@ -175,6 +236,7 @@ void CppPreprocessor::invalidDefinesInFile(const QString &fileName)
             const PDefine& p = mDefines.value(define->name);
             if (p == define) {
                 mDefines.remove(define->name);
+                invalidateExpansions();
             }
         }
         mFileDefines.remove(fileName);
@@ -305,6 +367,22 @@ void CppPreprocessor::removeScannedFile(const QString &filename)
     mScannedFiles.remove(filename);
     mIncludesList.remove(filename);
     mFileDefines.remove(filename);
+    mIncludeGraph.removeIncludes(filename);
+}
+
+void CppPreprocessor::addScannedFile(const PFileIncludes &fileIncludes, const PDefineMap &defines)
+{
+    mScannedFiles.insert(fileIncludes->baseFile);
+    mIncludesList.insert(fileIncludes->baseFile,fileIncludes);
+    foreach (const QString& file, fileIncludes->directIncludes)
+        mIncludeGraph.addInclude(fileIncludes->baseFile, file);
+    if (defines)
+        mFileDefines.insert(fileIncludes->baseFile,defines);
+}
+
+PDefineMap CppPreprocessor::fileDefines(const QString &fileName) const
+{
+    return mFileDefines.value(fileName, PDefineMap());
 }
 
 QString CppPreprocessor::getNextPreprocessor()
@@ -497,6 +575,7 @@ void CppPreprocessor::handleUndefine(const QString &line)
     if (define) {
         //remove the define from defines set
         mDefines.remove(name);
+        invalidateExpansions();
         //remove the define form the file where it defines
         if (define->filename == mFileName) {
             PDefineMap defineMap = mFileDefines.value(mFileName);
@@ -510,8 +589,10 @@ void CppPreprocessor::handleUndefine(const QString &line)
 QString CppPreprocessor::expandMacros(const QString &line, int depth)
 {
     //prevent infinit recursion
-    if (depth > MAX_DEFINE_EXPAND_DEPTH)
+    if (depth > MAX_DEFINE_EXPAND_DEPTH) {
+        mExpandDepthReached = true;
         return line;
+    }
     QString word;
     QString newLine;
     int lenLine = line.length();
@@ -565,9 +646,22 @@ void CppPreprocessor::expandMacro(const QString &line, QString &newLine, QString
     } else {
         PDefine define = getDefine(word);
         if (define && define->args=="" ) {
-            if (define->value != word )
-              newLine += expandMacros(define->value,depth+1);
-            else
+            if (define->value != word ) {
+                //the expansion doesn't depend on the rest of the line, reuse it until defines are changed
+                QHash<QString,QString>::const_iterator it = mMacroExpansions.constFind(word);
+                if (it != mMacroExpansions.constEnd()) {
+                    newLine += it.value();
+                } else {
+                    bool oldDepthReached = mExpandDepthReached;
+                    mExpandDepthReached = false;
+                    QString value = expandMacros(define->value,depth+1);
+                    //don't cache values cut by the depth limit
+                    if (!mExpandDepthReached)
+                        mMacroExpansions.insert(word,value);
+                    mExpandDepthReached = mExpandDepthReached || oldDepthReached;
+                    newLine += value;
+                }
+            } else
               newLine += word;
 
         } else if (define && (define->args!="")) {
@@ -658,6 +752,8 @@ void CppPreprocessor::removeGCCAttribute(const QString &line, QString &newLine,
 void CppPreprocessor::openInclude(const QString &fileName)
 {
     if (mIncludes.size()>0) {
+        //record the relation even if the file is already included by others
+        mIncludeGraph.addInclude(mIncludes.back()->fileName, fileName);
         PParsedFile topFile = mIncludes.front();
         if (topFile->fileIncludes->includeFiles.contains(fileName)) {
             return; //already included
@@ -717,9 +813,15 @@ void CppPreprocessor::openInclude(const QString &fileName)
         if ((mParseSystem && isSystemFile) || (mParseLocal && !isSystemFile)) {
             QStringList bufferedText;
             if (mOnGetFileStream && mOnGetFileStream(fileName,bufferedText)) {
-                parsedFile->buffer  = bufferedText;
+                parsedFile->buffer  = removeComments(bufferedText);
+            } else if (isSystemFile) {
+                QString includeGuard;
+                QStringList buffer = readSystemHeader(fileName, includeGuard);
+                //the whole file would be skipped by its include guard, don't process it
+                if (includeGuard.isEmpty() || !mDefines.contains(includeGuard))
+                    parsedFile->buffer = buffer;
             } else {
-                parsedFile->buffer = readFileToLines(fileName);
+                parsedFile->buffer = removeComments(readFileToLines(fileName));
             }
         }
     } else {
@@ -737,7 +839,6 @@ void CppPreprocessor::openInclude(const QString &fileName)
     // Process it
     mIndex = parsedFile->index;
     mFileName = parsedFile->fileName;
-    parsedFile->buffer = removeComments(parsedFile->buffer);
     mBuffer = parsedFile->buffer;
 
 //    for (int i=0;i<mBuffer.count();i++) {
@@ -796,6 +897,7 @@ void CppPreprocessor::addDefinesInFile(const QString &fileName)
         foreach (const PDefine& define, defineList->values()) {
             mDefines.insert(define->name,define);
         }
+        invalidateExpansions();
     }
 
     PFileIncludes fileIncludes = getFileIncludesEntry(fileName);
@@ -927,6 +1029,115 @@ QList<PDefineArgToken> CppPreprocessor::tokenizeValue(const QString &value)
     return tokens;
 }
 
+QString CppPreprocessor::detectIncludeGuard(const QStringList& lines)
+{
+    QString guard;
+    int state = 0; // 0: before #ifndef, 1: before #define, 2: inside the guard, 3: after #endif
+    int level = 0;
+    foreach (const QString& line, lines) {
+        QString s = line.trimmed();
+        if (s.isEmpty())
+            continue;
+        if (state == 3)
+            return QString();
+        if (!s.startsWith('#')) {
+            if (state < 2)
+                return QString();
+            continue;
+        }
+        s = s.mid(1).trimmed();
+        switch (state) {
+        case 0:
+            if (s.startsWith("ifndef")) {
+                guard = s.mid(6).trimmed();
+            } else if (s.startsWith("if")) {
+                s = s.mid(2).trimmed();
+                if (!s.startsWith('!'))
+                    return QString();
+                s = s.mid(1).trimmed();
+                if (!s.startsWith("defined"))
+                    return QString();
+                s = s.mid(7).trimmed();
+                if (s.startsWith('(') && s.endsWith(')'))
+                    s = s.mid(1,s.length()-2).trimmed();
+                guard = s;
+            } else
+                return QString();
+            for (int i=0;i<guard.length();i++) {
+                if (!isWordChar(guard[i]))
+                    return QString();
+            }
+            if (guard.isEmpty())
+                return QString();
+            state = 1;
+            level = 1;
+            break;
+        case 1:
+            if (!s.startsWith("define"))
+                return QString();
+            s = s.mid(6).trimmed();
+            if (!s.startsWith(guard)
+                    || (s.length()>guard.length() && isWordChar(s[guard.length()])))
+                return QString();
+            state = 2;
+            break;
+        case 2:
+            if (s.startsWith("if")) {
+                level++;
+            } else if (s.startsWith("endif")) {
+                level--;
+                if (level == 0)
+                    state = 3;
+            } else if (level == 1 && (s.startsWith("else") || s.startsWith("elif"))) {
+                return QString();
+            }
+            break;
+        }
+    }
+    if (state != 3)
+        return QString();
+    return guard;
+}
+
+QStringList CppPreprocessor::readSystemHeader(const QString &fileName, QString &includeGuard)
+{
+    QFileInfo info(fileName);
+    QDateTime lastModified = info.lastModified();
+    qint64 size = info.size();
+    {
+        QMutexLocker locker(&cachedHeadersMutex);
+        PCachedHeader header = cachedHeaders.value(fileName);
+        if (header && header->lastModified == lastModified && header->size == size) {
+            includeGuard = header->includeGuard;
+            return header->buffer;
+        }
+    }
+    std::shared_ptr<CachedHeader> header = std::make_shared<CachedHeader>();
+    header->lastModified = lastModified;
+    header->size = size;
+    header->buffer = removeComments(readFileToLines(fileName));
+    header->includeGuard = detectIncludeGuard(header->buffer);
+    qint64 chars = 0;
+    foreach (const QString& line, header->buffer)
+        chars += line.length();
+    {
+        QMutexLocker locker(&cachedHeadersMutex);
+        if (cachedHeaderChars + chars > MAX_CACHED_HEADER_CHARS) {
+            cachedHeaders.clear();
+            cachedHeaderChars = 0;
+        }
+        PCachedHeader oldHeader = cachedHeaders.value(fileName);
+        if (oldHeader) {
+            foreach (const QString& line, oldHeader->buffer)
+                cachedHeaderChars -= line.length();
+        }
+        cachedHeaders.insert(fileName, header);
+        cachedHeaderChars += chars;
+    }
+    includeGuard = header->includeGuard;
+    return header->buffer;
+}
+
 QStringList CppPreprocessor::removeComments(const QStringList &text)
 {
     QStringList result;
@@ -1180,8 +1391,13 @@ QString CppPreprocessor::lineBreak()
 
 bool CppPreprocessor::evaluateIf(const QString &line)
 {
+    QHash<QString,bool>::const_iterator it = mIfResults.constFind(line);
+    if (it != mIfResults.constEnd())
+        return it.value();
     QString newLine = expandDefines(line); // replace FOO by numerical value of FOO
-    return  evaluateExpression(newLine);
+    bool result = evaluateExpression(newLine);
+    mIfResults.insert(line,result);
+    return result;
 }
 
 QString CppPreprocessor::expandDefines(QString line)
@@ -1814,3 +2030,8 @@ QHash<QString, PFileIncludes> &CppPreprocessor::includesList()
     return mIncludesList;
 }
 
+const CppIncludeGraph &CppPreprocessor::includeGraph() const
+{
+    return mIncludeGraph;
+}
+
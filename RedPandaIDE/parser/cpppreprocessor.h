@@ -20,6 +20,7 @@
 #include <QObject>
 #include <QTextStream>
 #include "parserutils.h"
+#include "cppincludegraph.h"
 
 #define MAX_DEFINE_EXPAND_DEPTH 20
 enum class DefineArgTokenType{
@@ -71,6 +72,9 @@ public:
     void addHardDefineByLine(const QString& line);
     void setScanOptions(bool parseSystem, bool parseLocal);
     void preprocess(const QString& fileName);
+    // expand macros in lines [startLine, endLine] of an already scanned file, using the defines it has seen
+    // returns false if the lines can't be read or contain preprocessor directives
+    bool preprocessLines(const QString& fileName, int startLine, int endLine, QStringList& result);
 
     void dumpDefinesTo(const QString& fileName) const;
     void dumpIncludesListTo(const QString& fileName) const;
@@ -79,6 +83,8 @@ public:
     void clearIncludePaths();
     void clearProjectIncludePaths();
     void removeScannedFile(const QString& filename);
+    void addScannedFile(const PFileIncludes& fileIncludes, const PDefineMap& defines);
+    PDefineMap fileDefines(const QString& fileName) const;
 
     const QStringList& result() const{
         return mResult;
@@ -86,6 +92,8 @@ public:
 
     QHash<QString, PFileIncludes> &includesList();
 
+    const CppIncludeGraph &includeGraph() const;
+
     QSet<QString> &scannedFiles();
 
     const QSet<QString> &includePaths();
@@ -155,6 +163,10 @@ private:
     void parseArgs(PDefine define);
 
     QStringList removeComments(const QStringList& text);
+    // read a system header (comments removed), using the contents cached by all preprocessors if it's not modified
+    QStringList readSystemHeader(const QString& fileName, QString& includeGuard);
+    // macro of the include guard (#ifndef X / #define X ... #endif) wrapping the whole file
+    static QString detectIncludeGuard(const QStringList& lines);
     /*
      * '_','a'..'z','A'..'Z','0'..'9'
      */
@@ -194,6 +206,10 @@ static  bool isNumberChar(const QChar& ch);
     QString lineBreak();
 
     bool evaluateIf(const QString& line);
+    void invalidateExpansions() {
+        mMacroExpansions.clear();
+        mIfResults.clear();
+    }
     QString expandDefines(QString line);
     bool skipBraces(const QString&line, int& index, int step = 1);
     QString expandFunction(PDefine define,QString args);
@@ -227,6 +243,10 @@ private:
     QList<bool> mBranchResults;// stack of branch results (boolean). last one is current branch, first one is outermost branch
     DefineMap mDefines; // working set, editable
     QSet<QString> mProcessed; // dictionary to save filename already processed
+    //results only valid until mDefines is changed
+    QHash<QString,QString> mMacroExpansions; // expanded values of object-like macros
+    QHash<QString,bool> mIfResults; // results of #if/#elif conditions
+    bool mExpandDepthReached;
 
 
     //Result across processings.
@@ -234,6 +254,7 @@ private:
     QHash<QString,PFileIncludes> mIncludesList;
     QHash<QString, PDefineMap> mFileDefines; //dictionary to save defines for each headerfile;
     QSet<QString> mScannedFiles;
+    CppIncludeGraph mIncludeGraph;
 
     //option data for the parser
     //{ List of current project's include path }
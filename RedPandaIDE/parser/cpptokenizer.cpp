@@ -22,16 +22,18 @@
 
 CppTokenizer::CppTokenizer()
 {
-
+    mBracesMatched = true;
 }
 
 void CppTokenizer::clear()
 {
     mTokenList.clear();
+    mTokenTexts.clear();
     mBuffer.clear();
     mBufferStr.clear();
     mLastToken.clear();
     mUnmatchedBraces.clear();
+    mBracesMatched = true;
     mUnmatchedBrackets.clear();
     mUnmatchedParenthesis.clear();
     mLambdas.clear();
@@ -65,6 +67,8 @@ void CppTokenizer::tokenize(const QStringList &buffer)
         else
             addToken(s,mCurrentLine,tokenType);
     }
+    if (!mUnmatchedBraces.isEmpty())
+        mBracesMatched = false;
     while (!mUnmatchedBraces.isEmpty()) {
         addToken("}",mCurrentLine,TokenType::RightBrace);
     }
@@ -76,14 +80,21 @@ void CppTokenizer::tokenize(const QStringList &buffer)
     }
 }
 
+void CppTokenizer::swap(CppTokenizer &other)
+{
+    mTokenList.swap(other.mTokenList);
+    mLambdas.swap(other.mLambdas);
+    std::swap(mBracesMatched,other.mBracesMatched);
+}
+
 void CppTokenizer::dumpTokens(const QString &fileName)
 {
     QFile file(fileName);
 
     if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         QTextStream stream(&file);
-        foreach (const PToken& token,mTokenList) {
-            stream<<QString("%1,%2,%3").arg(token->line).arg(token->text).arg(token->matchIndex)
+        foreach (const Token& token,mTokenList) {
+            stream<<QString("%1,%2,%3").arg(token.line).arg(token.text).arg(token.matchIndex)
 #if QT_VERSION >= QT_VERSION_CHECK(5,15,0)
                  <<Qt::endl;
 #else
@@ -95,49 +106,42 @@ void CppTokenizer::dumpTokens(const QString &fileName)
 
 void CppTokenizer::addToken(const QString &sText, int iLine, TokenType tokenType)
 {
-    PToken token = std::make_shared<Token>();
-    token->text = sText;
-    token->line = iLine;
-#ifdef Q_DEBUG
-    token->matchIndex = 1000000000;
-#endif
+    Token token;
+    QSet<QString>::const_iterator it = mTokenTexts.constFind(sText);
+    if (it == mTokenTexts.constEnd())
+        it = mTokenTexts.insert(sText);
+    token.text = *it;
+    token.line = iLine;
+    token.matchIndex = -1;
     switch(tokenType) {
     case TokenType::LeftBrace:
-        token->matchIndex=-1;
         mUnmatchedBraces.push_back(mTokenList.count());
         break;
     case TokenType::RightBrace:
-        if (mUnmatchedBraces.isEmpty()) {
-            token->matchIndex=-1;
-        } else {
-            token->matchIndex = mUnmatchedBraces.last();
-            mTokenList[token->matchIndex]->matchIndex=mTokenList.count();
+        if (!mUnmatchedBraces.isEmpty()) {
+            token.matchIndex = mUnmatchedBraces.last();
+            mTokenList[token.matchIndex].matchIndex=mTokenList.count();
             mUnmatchedBraces.pop_back();
-        }
+        } else
+            mBracesMatched = false;
         break;
     case TokenType::LeftBracket:
-        token->matchIndex=-1;
         mUnmatchedBrackets.push_back(mTokenList.count());
         break;
     case TokenType::RightBracket:
-        if (mUnmatchedBrackets.isEmpty()) {
-            token->matchIndex=-1;
-        } else {
-            token->matchIndex = mUnmatchedBrackets.last();
-            mTokenList[token->matchIndex]->matchIndex=mTokenList.count();
+        if (!mUnmatchedBrackets.isEmpty()) {
+            token.matchIndex = mUnmatchedBrackets.last();
+            mTokenList[token.matchIndex].matchIndex=mTokenList.count();
             mUnmatchedBrackets.pop_back();
         }
         break;
     case TokenType::LeftParenthesis:
-        token->matchIndex=-1;
         mUnmatchedParenthesis.push_back(mTokenList.count());
         break;
     case TokenType::RightParenthesis:
-        if (mUnmatchedParenthesis.isEmpty()) {
-            token->matchIndex=-1;
-        } else {
-            token->matchIndex = mUnmatchedParenthesis.last();
-            mTokenList[token->matchIndex]->matchIndex=mTokenList.count();
+        if (!mUnmatchedParenthesis.isEmpty()) {
+            token.matchIndex = mUnmatchedParenthesis.last();
+            mTokenList[token.matchIndex].matchIndex=mTokenList.count();
             mUnmatchedParenthesis.pop_back();
         }
         break;
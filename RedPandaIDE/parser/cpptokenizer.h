@@ -40,21 +40,27 @@ public:
       int line;
       int matchIndex;
     };
-    using PToken = std::shared_ptr<Token>;
-    using TokenList = QVector<PToken>;
+    // points into the token array, valid until the next tokenize() or clear()
+    using PToken = const Token*;
+    using TokenList = QVector<Token>;
     explicit CppTokenizer();
     CppTokenizer(const CppTokenizer&)=delete;
     CppTokenizer& operator=(const CppTokenizer&)=delete;
 
     void clear();
     void tokenize(const QStringList& buffer);
+    void swap(CppTokenizer& other); // exchange tokenize results
     void dumpTokens(const QString& fileName);
-    const PToken& operator[](int i) const {
-        return mTokenList[i];
+    PToken operator[](int i) const {
+        return &mTokenList.at(i);
     }
     int tokenCount() const {
         return mTokenList.count();
     }
+    // false if braces were added or left unmatched to balance the buffer
+    bool bracesMatched() const {
+        return mBracesMatched;
+    }
     static bool isIdentChar(const QChar& ch) {
             return ch=='_' || ch.isLetter() ;
     }
@@ -165,8 +171,10 @@ private:
     int mCurrentLine;
     QString mLastToken;
     TokenList mTokenList;
+    QSet<QString> mTokenTexts; // texts of tokens in the file, shared by tokens with the same text
     QList<int> mLambdas;
     QVector<int> mUnmatchedBraces; // stack of indices for unmatched '{'
+    bool mBracesMatched;
     QVector<int> mUnmatchedBrackets; // stack of indices for unmatched '['
     QVector<int> mUnmatchedParenthesis;// stack of indices for unmatched '('
 };
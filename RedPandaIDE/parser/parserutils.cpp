@@ -558,6 +558,29 @@ void CppScopes::clear()
     mScopes.clear();
 }
 
+const QVector<PCppScope> &CppScopes::scopes() const
+{
+    return mScopes;
+}
+
+QVector<PCppScope> CppScopes::takeScopesFrom(int index)
+{
+    QVector<PCppScope> result;
+    if (index<0 || index>=mScopes.size())
+        return result;
+    result = mScopes.mid(index);
+    mScopes.resize(index);
+    return result;
+}
+
+void CppScopes::appendScopes(const QVector<PCppScope> &scopes, int lineDelta)
+{
+    foreach (const PCppScope& scope, scopes) {
+        scope->startLine += lineDelta;
+        mScopes.append(scope);
+    }
+}
+
 MemberOperatorType getOperatorType(const QString &phrase, int index)
 {
     if (index>=phrase.length())
@@ -150,7 +150,8 @@ enum StatementProperty {
     spVirtual = 0x0020,
     spOverride = 0x0040,
     spConstexpr = 0x0080,
-    spFunctionPointer = 0x0100
+    spFunctionPointer = 0x0100,
+    spShared = 0x0200
 };
 
 Q_DECLARE_FLAGS(StatementProperties, StatementProperty)
@@ -188,14 +189,6 @@ struct Statement {
     QString noNameArgs;// Args without name
     StatementProperties properties;
 
-    // fields for code completion
-    int usageCount; //Usage Count
-    int matchPosTotal; // total of matched positions
-    int matchPosSpan; // distance between the first match pos and the last match pos;
-    int firstMatchLength; // length of first match;
-    int caseMatched; // if match with case
-    QList<PStatementMathPosition> matchPositions;
-
     // definiton line/filename is valid
     bool hasDefinition() {
         return properties.testFlag(StatementProperty::spHasDefinition);
@@ -226,6 +219,10 @@ struct Statement {
     bool isInherited() {
         return properties.testFlag(StatementProperty::spInherited);
     }; // inherted member;
+    // statement in the shared system header index, must not be modified
+    bool isShared() {
+        return properties.testFlag(StatementProperty::spShared);
+    }
 
 };
 
@@ -280,6 +277,9 @@ public:
     PStatement lastScope();
     void removeLastScope();
     void clear();
+    const QVector<PCppScope> &scopes() const;
+    QVector<PCppScope> takeScopesFrom(int index);
+    void appendScopes(const QVector<PCppScope>& scopes, int lineDelta);
 private:
     QVector<PCppScope> mScopes;
 };
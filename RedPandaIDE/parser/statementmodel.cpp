@@ -30,11 +30,19 @@ void StatementModel::add(const PStatement& statement)
         return ;
     }
     PStatement parent = statement->parentScope.lock();
-    if (parent) {
+    if (parent && !parent->isShared()) {
         addMember(parent->children,statement);
+    } else if (parent) {
+        //children of shared statements can't be modified
+        addMember(mSharedChildren[parent.get()],statement);
     } else {
         addMember(mGlobalStatements,statement);
     }
+    //children of shared statements are not added one by one
+    if (statement->isShared()) {
+        foreach (const PStatement& child, statement->children)
+            addSharedNames(child);
+    }
     mCount++;
 #ifdef QT_DEBUG
     mAllStatements.append(statement);
@@ -49,11 +57,23 @@ void StatementModel::deleteStatement(const PStatement& statement)
     }
     PStatement parent = statement->parentScope.lock();
     int count = 0;
-    if (parent) {
+    if (parent && !parent->isShared()) {
         count = deleteMember(parent->children,statement);
+    } else if (parent) {
+        QHash<const Statement*, StatementMap>::iterator it = mSharedChildren.find(parent.get());
+        if (it != mSharedChildren.end()) {
+            count = deleteMember(it.value(),statement);
+            if (it.value().isEmpty())
+                mSharedChildren.erase(it);
+        }
     } else {
         count = deleteMember(mGlobalStatements,statement);
     }
+    if (count>0 && statement->isShared()) {
+        foreach (const PStatement& child, statement->children)
+            removeSharedNames(child);
+        removeSharedChildren(statement);
+    }
     mCount -= count;
 #ifdef QT_DEBUG
     mAllStatements.removeOne(statement);
@@ -61,29 +81,60 @@ void StatementModel::deleteStatement(const PStatement& statement)
 
 }
 
-const StatementMap &StatementModel::childrenStatements(const PStatement& statement) const
+StatementMap StatementModel::childrenStatements(const PStatement& statement) const
 {
     if (!statement) {
         return mGlobalStatements;
-    } else {
-        return statement->children;
     }
+    if (statement->isShared()) {
+        QHash<const Statement*, StatementMap>::const_iterator it = mSharedChildren.constFind(statement.get());
+        if (it != mSharedChildren.constEnd()) {
+            StatementMap children = statement->children;
+            for (StatementMap::const_iterator childIt = it.value().constBegin();
+                 childIt != it.value().constEnd(); ++childIt) {
+                children.insert(childIt.key(), childIt.value());
+            }
+            return children;
+        }
+    }
+    return statement->children;
 }
 
-const StatementMap &StatementModel::childrenStatements(std::weak_ptr<Statement> statement) const
+StatementMap StatementModel::childrenStatements(std::weak_ptr<Statement> statement) const
 {
     PStatement s = statement.lock();
     return childrenStatements(s);
 }
 
+StatementList StatementModel::childrenStatementsNamed(const PStatement &statement, const QString &name) const
+{
+    if (!statement) {
+        return mGlobalStatements.values(name);
+    }
+    if (statement->isShared()) {
+        QHash<const Statement*, StatementMap>::const_iterator it = mSharedChildren.constFind(statement.get());
+        //the ones added in this model first, like QMultiMap::values()
+        if (it != mSharedChildren.constEnd())
+            return it.value().values(name) + statement->children.values(name);
+    }
+    return statement->children.values(name);
+}
+
 void StatementModel::clear() {
     mCount=0;
     mGlobalStatements.clear();
+    mSharedChildren.clear();
+    mNameCounts.clear();
 #ifdef QT_DEBUG
     mAllStatements.clear();
 #endif
 }
 
+bool StatementModel::containsName(const QString &name) const
+{
+    return mNameCounts.contains(name);
+}
+
 void StatementModel::dump(const QString &logFile)
 {
     QFile file(logFile);
@@ -119,6 +170,7 @@ void StatementModel::addMember(StatementMap &map, const PStatement& statement)
     if (!statement)
         return ;
     map.insert(statement->command,statement);
+    addName(statement->command);
 //    QList<PStatement> lst = map.values(statement->command);
 //    if (!lst) {
 //        lst=std::make_shared<StatementList>();
@@ -131,7 +183,106 @@ int StatementModel::deleteMember(StatementMap &map, const PStatement& statement)
 {
     if (!statement)
         return 0;
-    return map.remove(statement->command,statement);
+    int count = map.remove(statement->command,statement);
+    for (int i=0;i<count;i++)
+        removeName(statement->command);
+    return count;
+}
+
+void StatementModel::addName(const QString &name)
+{
+    mNameCounts[name]++;
+}
+
+void StatementModel::removeName(const QString &name)
+{
+    QHash<QString,int>::iterator it = mNameCounts.find(name);
+    if (it==mNameCounts.end())
+        return;
+    if (--it.value()<=0)
+        mNameCounts.erase(it);
+}
+
+void StatementModel::addSharedNames(const PStatement &statement)
+{
+    addName(statement->command);
+    foreach (const PStatement& child, statement->children)
+        addSharedNames(child);
+}
+
+void StatementModel::removeSharedNames(const PStatement &statement)
+{
+    removeName(statement->command);
+    foreach (const PStatement& child, statement->children)
+        removeSharedNames(child);
+}
+
+void StatementModel::removeSharedChildren(const PStatement &statement)
+{
+    QHash<const Statement*, StatementMap>::iterator it = mSharedChildren.find(statement.get());
+    if (it == mSharedChildren.end())
+        return;
+    //names of the shared children are removed by removeSharedNames()
+    for (StatementMap::const_iterator childIt = it.value().constBegin();
+         childIt != it.value().constEnd(); ++childIt) {
+        removeName(childIt.key());
+    }
+    mSharedChildren.erase(it);
+}
+
+static void countStringBytes(const QString& s, QSet<const QChar*>& strings,
+                             qint64& stringBytes, qint64& unsharedStringBytes)
+{
+    if (s.isEmpty())
+        return;
+    qint64 bytes = s.capacity()*sizeof(QChar);
+    unsharedStringBytes += bytes;
+    if (!strings.contains(s.constData())) {
+        strings.insert(s.constData());
+        stringBytes += bytes;
+    }
+}
+
+static void countMemoryUsage(const StatementMap& map, int& count, QSet<const QChar*>& strings,
+                             qint64& stringBytes, qint64& unsharedStringBytes)
+{
+    foreach (const PStatement& statement, map) {
+        count++;
+        countStringBytes(statement->type,strings,stringBytes,unsharedStringBytes);
+        countStringBytes(statement->command,strings,stringBytes,unsharedStringBytes);
+        countStringBytes(statement->args,strings,stringBytes,unsharedStringBytes);
+        countStringBytes(statement->value,strings,stringBytes,unsharedStringBytes);
+        countStringBytes(statement->fileName,strings,stringBytes,unsharedStringBytes);
+        countStringBytes(statement->definitionFileName,strings,stringBytes,unsharedStringBytes);
+        countStringBytes(statement->fullName,strings,stringBytes,unsharedStringBytes);
+        countStringBytes(statement->noNameArgs,strings,stringBytes,unsharedStringBytes);
+        foreach (const QString& s, statement->friends)
+            countStringBytes(s,strings,stringBytes,unsharedStringBytes);
+        foreach (const QString& s, statement->usingList)
+            countStringBytes(s,strings,stringBytes,unsharedStringBytes);
+        countMemoryUsage(statement->children,count,strings,stringBytes,unsharedStringBytes);
+    }
+}
+
+void StatementModel::dumpMemoryUsage(const QString &logFile)
+{
+    QFile file(logFile);
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        int count = 0;
+        QSet<const QChar*> strings;
+        qint64 stringBytes = 0; // string data really allocated
+        qint64 unsharedStringBytes = 0; // string data if no string is shared
+        countMemoryUsage(mGlobalStatements,count,strings,stringBytes,unsharedStringBytes);
+        QTextStream out(&file);
+        out<<QString("statements: %1").arg(count)<<"\n";
+        out<<QString("sizeof(Statement): %1").arg(sizeof(Statement))<<"\n";
+        out<<QString("string bytes: %1").arg(stringBytes)<<"\n";
+        out<<QString("string bytes without sharing: %1").arg(unsharedStringBytes)<<"\n";
+        if (count>0) {
+            out<<QString("bytes per statement: %1").arg((sizeof(Statement)*count+stringBytes)/count)<<"\n";
+            out<<QString("bytes per statement without sharing: %1").arg((sizeof(Statement)*count+unsharedStringBytes)/count)<<"\n";
+        }
+    }
 }
 
 void StatementModel::dumpStatementMap(StatementMap &map, QTextStream &out, int level)
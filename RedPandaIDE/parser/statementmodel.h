@@ -17,6 +17,7 @@
 #ifndef STATEMENTMODEL_H
 #define STATEMENTMODEL_H
 
+#include <QHash>
 #include <QObject>
 #include <QTextStream>
 #include "parserutils.h"
@@ -33,10 +34,14 @@ public:
 //    function DeleteFirst: Integer;
 //    function DeleteLast: Integer;
     void deleteStatement(const PStatement& statement);
-    const StatementMap& childrenStatements(const PStatement& statement = PStatement()) const;
-    const StatementMap& childrenStatements(std::weak_ptr<Statement> statement) const;
+    StatementMap childrenStatements(const PStatement& statement = PStatement()) const;
+    StatementMap childrenStatements(std::weak_ptr<Statement> statement) const;
+    // children with the name, without copying the children of shared statements
+    StatementList childrenStatementsNamed(const PStatement& statement, const QString& name) const;
     void clear();
+    bool containsName(const QString& name) const;
     void dump(const QString& logFile);
+    void dumpMemoryUsage(const QString& logFile);
 #ifdef QT_DEBUG
     void dumpAll(const QString& logFile);
 #endif
@@ -44,9 +49,18 @@ private:
     void addMember(StatementMap& map, const PStatement& statement);
     int deleteMember(StatementMap& map, const PStatement& statement);
     void dumpStatementMap(StatementMap& map, QTextStream& out, int level);
+    void addName(const QString& name);
+    void removeName(const QString& name);
+    void addSharedNames(const PStatement& statement);
+    void removeSharedNames(const PStatement& statement);
+    void removeSharedChildren(const PStatement& statement);
 private:
     int mCount;
+    QHash<QString,int> mNameCounts; // command -> statements in the model using it
     StatementMap mGlobalStatements;  //may have overloaded functions, so use PStatementList to store
+    //children of shared statements can't be modified, so children added to them in this model
+    //are saved here; they are merged with the shared ones when looked up
+    QHash<const Statement*, StatementMap> mSharedChildren;
 #ifdef QT_DEBUG
     StatementList mAllStatements;
 #endif
@@ -16,8 +16,56 @@
  */
 #include "problemcasevalidator.h"
 #include "../utils.h"
+#include <QBuffer>
+#include <QFile>
+#include <QTextCodec>
 
-ProblemCaseValidator::ProblemCaseValidator()
+#define EXPECTED_BUFFER_SIZE 65536
+//tokens longer than this are never treated as numbers
+#define MAX_NUMBER_LENGTH 64
+
+static bool isSpaceChar(char ch)
+{
+    switch(ch) {
+    case ' ':
+    case '\t':
+    case '\v':
+    case '\f':
+    case '\r':
+        return true;
+    }
+    return false;
+}
+
+//non-ascii spaces (like U+00A0 or U+3000) become ' ', so tokens are split like QChar::isSpace()
+static QByteArray toCompared(QString s, bool ignoreSpaces)
+{
+    if (ignoreSpaces) {
+        for (int i=0;i<s.length();i++) {
+            if (s[i].unicode()>=128 && s[i].isSpace())
+                s[i]=' ';
+        }
+    }
+    return s.toUtf8();
+}
+
+static bool isSeparator(int ch)
+{
+    return ch==' ' || ch=='\n' || ch<0;
+}
+
+ProblemCaseValidator::ProblemCaseValidator():
+    mIgnoreSpaces(false),
+    mFloatTolerance(0),
+    mFailed(false),
+    mDiffLine(-1),
+    mComparedLines(0),
+    mExpectedPos(0),
+    mExpectedEnd(true),
+    mExpectedPendingCount(0),
+    mExpectedPendingPos(0),
+    mComparingNumber(false),
+    mExpectedSeparator(-1)
 {
 
 }
@@ -26,57 +74,279 @@ bool ProblemCaseValidator::validate(POJProblemCase problemCase, bool ignoreSpace
 {
     if (!problemCase)
         return false;
-    QStringList output = textToLines(problemCase->output);
-    QStringList expected;
-    if (fileExists(problemCase->expectedOutputFileName))
-        expected = readFileToLines(problemCase->expectedOutputFileName);
-    else
-        expected = textToLines(problemCase->expected);
-    problemCase->outputLineCounts = output.count();
-    problemCase->expectedLineCounts = expected.count();
-    if (output.count()!=expected.count())
-        return false;
-    for (int i=0;i<output.count();i++) {
-        if (ignoreSpaces) {
-            if (!equalIgnoringSpaces(output[i],expected[i])) {
-                problemCase->firstDiffLine = i;
-                return false;
+    begin(problemCase, ignoreSpaces);
+    QByteArray output = toCompared(problemCase->output, ignoreSpaces);
+    compareOutput(output.constData(), output.length());
+    return finish();
+}
+
+void ProblemCaseValidator::begin(POJProblemCase problemCase, bool ignoreSpaces, double floatTolerance)
+{
+    mProblemCase = problemCase;
+    mIgnoreSpaces = ignoreSpaces;
+    mFloatTolerance = ignoreSpaces?floatTolerance:0;
+    mFailed = false;
+    mDiffLine = -1;
+    mComparedLines = 0;
+    mOutputNormalizer.reset(ignoreSpaces);
+    mExpectedNormalizer.reset(ignoreSpaces);
+    mExpectedPos = 0;
+    mExpectedEnd = false;
+    mExpectedPendingCount = 0;
+    mExpectedPendingPos = 0;
+    mComparingNumber = false;
+    mExpectedSeparator = -1;
+    mOutputToken.clear();
+    mExpectedToken.clear();
+    mExpectedBuffer.clear();
+    mOutputDecoder.reset();
+    mExpectedDecoder.reset();
+    //compare in utf-8
+    QTextCodec* localeCodec = QTextCodec::codecForLocale();
+    //the non-ascii spaces can only be found in decoded text
+    if (localeCodec->mibEnum()!=106 || ignoreSpaces)
+        mOutputDecoder.reset(localeCodec->makeDecoder());
+    if (fileExists(problemCase->expectedOutputFileName)) {
+        QFile* file = new QFile(problemCase->expectedOutputFileName);
+        mExpected.reset(file);
+        if (file->open(QFile::ReadOnly)) {
+            //like readFileToLines(), fall back to the local encoding if the file is not utf-8
+            QByteArray head = file->peek(EXPECTED_BUFFER_SIZE);
+            QTextCodec::ConverterState state;
+            QTextCodec::codecForName("UTF-8")->toUnicode(head.constData(),head.length(),&state);
+            if (state.invalidChars>0 && localeCodec->mibEnum()!=106)
+                mExpectedDecoder.reset(localeCodec->makeDecoder());
+            else if (ignoreSpaces)
+                mExpectedDecoder.reset(QTextCodec::codecForName("UTF-8")->makeDecoder());
+        }
+    } else {
+        QBuffer* buffer = new QBuffer();
+        buffer->setData(toCompared(problemCase->expected, ignoreSpaces));
+        buffer->open(QIODevice::ReadOnly);
+        mExpected.reset(buffer);
+    }
+    if (!mExpected->isOpen())
+        mExpectedEnd = true;
+}
+
+void ProblemCaseValidator::addOutput(const QByteArray &output)
+{
+    if (mOutputDecoder) {
+        QByteArray s = toCompared(mOutputDecoder->toUnicode(output), mIgnoreSpaces);
+        compareOutput(s.constData(),s.length());
+    } else {
+        compareOutput(output.constData(),output.length());
+    }
+}
+
+bool ProblemCaseValidator::finish()
+{
+    char buf[2];
+    int n = mOutputNormalizer.finish(buf);
+    for (int i=0;i<n;i++)
+        compareOutputChar((unsigned char)buf[i]);
+    //end of output
+    compareOutputChar(-1);
+    //count the remaining expected lines
+    while (nextExpected()>=0)
+        ;
+    mExpected.reset();
+    mProblemCase->outputLineCounts = mOutputNormalizer.lineCount();
+    mProblemCase->expectedLineCounts = mExpectedNormalizer.lineCount();
+    mProblemCase->firstDiffLine = mDiffLine;
+    return !mFailed && mProblemCase->outputLineCounts == mProblemCase->expectedLineCounts;
+}
+
+void ProblemCaseValidator::compareOutput(const char *p, int length)
+{
+    char buf[2];
+    const char* end = p + length;
+    while (p<end) {
+        int n = mOutputNormalizer.feed(*p,buf);
+        p++;
+        //only count lines after the first difference
+        if (mFailed)
+            continue;
+        for (int i=0;i<n;i++)
+            compareOutputChar((unsigned char)buf[i]);
+    }
+}
+
+//ch is -1 at the end of output
+void ProblemCaseValidator::compareOutputChar(int ch)
+{
+    if (mFailed)
+        return;
+    if (mComparingNumber) {
+        if (!isSeparator(ch)) {
+            appendTokenChar(mOutputToken,ch);
+            return;
+        }
+        mComparingNumber = false;
+        if (!tokensEqual() || ch!=mExpectedSeparator) {
+            fail();
+            return;
+        }
+    } else {
+        int e = nextExpected();
+        if (e!=ch) {
+            if (mFloatTolerance<=0 || (isSeparator(ch) && isSeparator(e))) {
+                fail();
+                return;
             }
-        } else {
-            if (output[i]!=expected[i]) {
-                problemCase->firstDiffLine = i;
-                return false;
+            //read both tokens to the end and compare them as numbers
+            while (!isSeparator(e)) {
+                appendTokenChar(mExpectedToken,e);
+                e = nextExpected();
+            }
+            mExpectedSeparator = e;
+            if (!isSeparator(ch)) {
+                appendTokenChar(mOutputToken,ch);
+                mComparingNumber = true;
+                return;
+            }
+            if (!tokensEqual() || ch!=mExpectedSeparator) {
+                fail();
+                return;
             }
         }
     }
+    if (ch=='\n')
+        mComparedLines++;
+    if (mFloatTolerance>0) {
+        if (isSeparator(ch)) {
+            mOutputToken.clear();
+            mExpectedToken.clear();
+        } else {
+            appendTokenChar(mOutputToken,ch);
+            appendTokenChar(mExpectedToken,ch);
+        }
+    }
+}
+
+int ProblemCaseValidator::nextExpected()
+{
+    while (mExpectedPendingPos>=mExpectedPendingCount) {
+        mExpectedPendingPos = 0;
+        if (mExpectedPos>=mExpectedBuffer.length() && !readExpected()) {
+            mExpectedPendingCount = mExpectedNormalizer.finish(mExpectedPending);
+            if (mExpectedPendingCount==0)
+                return -1;
+            continue;
+        }
+        mExpectedPendingCount = mExpectedNormalizer.feed(mExpectedBuffer.at(mExpectedPos),mExpectedPending);
+        mExpectedPos++;
+    }
+    unsigned char ch = mExpectedPending[mExpectedPendingPos];
+    mExpectedPendingPos++;
+    return ch;
+}
+
+bool ProblemCaseValidator::readExpected()
+{
+    if (mExpectedEnd)
+        return false;
+    mExpectedBuffer = mExpected->read(EXPECTED_BUFFER_SIZE);
+    mExpectedPos = 0;
+    if (mExpectedBuffer.isEmpty()) {
+        mExpectedEnd = true;
+        return false;
+    }
+    if (mExpectedDecoder)
+        mExpectedBuffer = toCompared(mExpectedDecoder->toUnicode(mExpectedBuffer), mIgnoreSpaces);
     return true;
 }
 
-bool ProblemCaseValidator::equalIgnoringSpaces(const QString &s1, const QString &s2)
+void ProblemCaseValidator::appendTokenChar(QByteArray &token, int ch)
 {
-    QStringList strList1=split(s1);
-    QStringList strList2=split(s2);
-    return (strList1==strList2);
+    if (token.length()<=MAX_NUMBER_LENGTH)
+        token.append((char)ch);
 }
 
-QStringList ProblemCaseValidator::split(const QString &s)
+bool ProblemCaseValidator::tokensEqual()
 {
-    QStringList result;
-    const QChar* p = s.data();
-    const QChar* start = p;
-    while (p->unicode()!=0) {
-        if (p->isSpace()) {
-            if (!start->isSpace()) {
-                result.append(QString(start,p-start));
-            }
-            start = p;
-        } else if (start->isSpace()) {
-            start = p;
+    if (mOutputToken.length()>MAX_NUMBER_LENGTH || mExpectedToken.length()>MAX_NUMBER_LENGTH)
+        return false;
+    bool ok;
+    double outputValue = mOutputToken.toDouble(&ok);
+    if (!ok)
+        return false;
+    double expectedValue = mExpectedToken.toDouble(&ok);
+    if (!ok)
+        return false;
+    //absolute or relative error
+    return qAbs(outputValue-expectedValue) <= mFloatTolerance*qMax(1.0,qAbs(expectedValue));
+}
+
+void ProblemCaseValidator::fail()
+{
+    mFailed = true;
+    mDiffLine = mComparedLines;
+}
+
+void ProblemCaseValidator::Normalizer::reset(bool ignoreSpaces)
+{
+    mIgnoreSpaces = ignoreSpaces;
+    mLineEnded = false;
+    mPendingCR = false;
+    mPendingSpace = false;
+    mHasToken = false;
+    mLineCount = 0;
+}
+
+int ProblemCaseValidator::Normalizer::feed(char ch, char *out)
+{
+    int n=0;
+    if (mLineCount==0 || mLineEnded) {
+        if (mLineEnded)
+            out[n++]='\n';
+        mLineCount++;
+        mLineEnded = false;
+        mPendingSpace = false;
+        mHasToken = false;
+    }
+    if (ch=='\n') {
+        //"\r\n" is a line break, like QTextStream::readLine()
+        mPendingCR = false;
+        mLineEnded = true;
+        return n;
+    }
+    if (mIgnoreSpaces) {
+        if (isSpaceChar(ch)) {
+            if (mHasToken)
+                mPendingSpace = true;
+            return n;
+        }
+        if (mPendingSpace) {
+            out[n++]=' ';
+            mPendingSpace = false;
+        }
+        mHasToken = true;
+    } else {
+        if (mPendingCR) {
+            out[n++]='\r';
+            mPendingCR = false;
+        }
+        if (ch=='\r') {
+            mPendingCR = true;
+            return n;
         }
-        p++;
     }
-    if (!start->isSpace()) {
-        result.append(QString(start,p-start));
+    out[n++]=ch;
+    return n;
+}
+
+int ProblemCaseValidator::Normalizer::finish(char *out)
+{
+    if (mPendingCR) {
+        mPendingCR = false;
+        out[0]='\r';
+        return 1;
     }
-    return result;
+    return 0;
+}
+
+int ProblemCaseValidator::Normalizer::lineCount() const
+{
+    return mLineCount;
 }
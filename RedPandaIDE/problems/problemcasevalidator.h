@@ -17,16 +17,71 @@
 #ifndef PROBLEMCASEVALIDATOR_H
 #define PROBLEMCASEVALIDATOR_H
 
+#include <QByteArray>
+#include <QIODevice>
+#include <QTextDecoder>
+#include <memory>
 #include "ojproblemset.h"
 
+//Compares the program output with the expected output while the output is produced.
+//Only the current chunk (and in float mode the current token) is kept in memory.
 class ProblemCaseValidator
 {
 public:
     ProblemCaseValidator();
     bool validate(POJProblemCase problemCase,bool ignoreSpaces);
+
+    //floatTolerance is only used when ignoreSpaces is set; 0 disables it
+    void begin(POJProblemCase problemCase, bool ignoreSpaces, double floatTolerance=0);
+    //output of the program, in the local encoding
+    void addOutput(const QByteArray& output);
+    bool finish();
+private:
+    //Normalized text is the lines joined by '\n', without the trailing line break.
+    //When ignoring spaces, each line is its tokens joined by a single ' '.
+    class Normalizer {
+    public:
+        void reset(bool ignoreSpaces);
+        int feed(char ch, char* out);
+        int finish(char* out);
+        int lineCount() const;
+    private:
+        bool mIgnoreSpaces;
+        bool mLineEnded;
+        bool mPendingCR;
+        bool mPendingSpace;
+        bool mHasToken;
+        int mLineCount;
+    };
+    void compareOutput(const char* p, int length);
+    void compareOutputChar(int ch);
+    int nextExpected();
+    bool readExpected();
+    void appendTokenChar(QByteArray& token, int ch);
+    bool tokensEqual();
+    void fail();
 private:
-    bool equalIgnoringSpaces(const QString& s1, const QString& s2);
-    QStringList split(const QString& s);
+    POJProblemCase mProblemCase;
+    bool mIgnoreSpaces;
+    double mFloatTolerance;
+    bool mFailed;
+    int mDiffLine;
+    int mComparedLines;
+    Normalizer mOutputNormalizer;
+    Normalizer mExpectedNormalizer;
+    std::unique_ptr<QTextDecoder> mOutputDecoder;
+    std::unique_ptr<QTextDecoder> mExpectedDecoder;
+    std::unique_ptr<QIODevice> mExpected;
+    QByteArray mExpectedBuffer;
+    int mExpectedPos;
+    bool mExpectedEnd;
+    char mExpectedPending[2];
+    int mExpectedPendingCount;
+    int mExpectedPendingPos;
+    bool mComparingNumber;
+    int mExpectedSeparator;
+    QByteArray mOutputToken;
+    QByteArray mExpectedToken;
 };
 
 #endif // PROBLEMCASEVALIDATOR_H
@@ -59,8 +59,8 @@ Project::Project(const QString &filename, const QString &name,
     mParser = std::make_shared<CppParser>();
     mParser->setOnGetFileStream(
                 std::bind(
-                    &EditorList::getContentFromOpenedEditor,mEditorList,
-                    std::placeholders::_1, std::placeholders::_2));
+                    &EditorList::getContentForParser,mEditorList,
+                    mParser.get(), std::placeholders::_1, std::placeholders::_2));
 }
 
 std::shared_ptr<Project> Project::load(const QString &filename, EditorList *editorList, QFileSystemWatcher *fileSystemWatcher, QObject *parent)
@@ -696,7 +696,7 @@ void Project::renameUnit(PProjectUnit& unit, const QString &newFileName)
             mParser->invalidateFile(unit->fileName());
         copyFile(unit->fileName(),newFileName,true);
         if (mParser)
-            mParser->parseFile(newFileName,true);
+            mParser->queueParseFile(newFileName,true);
     }
 
     internalRemoveUnit(unit,false,true);
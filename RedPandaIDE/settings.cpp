@@ -26,6 +26,7 @@
 #include <QStandardPaths>
 #include <QScreen>
 #include <QDesktopWidget>
+#include <QThread>
 #ifdef Q_OS_LINUX
 #include <sys/sysinfo.h>
 #endif
@@ -567,6 +568,26 @@ void Settings::Editor::setEnableAutolink(bool newEnableAutolink)
     mEnableAutolink = newEnableAutolink;
 }
 
+bool Settings::Editor::enableCompileCache() const
+{
+    return mEnableCompileCache;
+}
+
+void Settings::Editor::setEnableCompileCache(bool newEnableCompileCache)
+{
+    mEnableCompileCache = newEnableCompileCache;
+}
+
+int Settings::Editor::compileCacheMaxSize() const
+{
+    return mCompileCacheMaxSize;
+}
+
+void Settings::Editor::setCompileCacheMaxSize(int newCompileCacheMaxSize)
+{
+    mCompileCacheMaxSize = newCompileCacheMaxSize;
+}
+
 const QColor &Settings::Editor::rightEdgeLineColor() const
 {
     return mRightEdgeLineColor;
@@ -1396,6 +1417,10 @@ void Settings::Editor::doSave()
     //auto link
     saveValue("enable_autolink",mEnableAutolink);
 
+    //compile cache
+    saveValue("enable_compile_cache",mEnableCompileCache);
+    saveValue("compile_cache_max_size",mCompileCacheMaxSize);
+
     //misc
     saveValue("default_encoding",mDefaultEncoding);
     saveValue("readonly_system_header",mReadOnlySytemHeader);
@@ -1548,6 +1573,10 @@ void Settings::Editor::doLoad()
     //auto link
     mEnableAutolink = boolValue("enable_autolink",true);
 
+    //compile cache
+    mEnableCompileCache = boolValue("enable_compile_cache",false);
+    mCompileCacheMaxSize = intValue("compile_cache_max_size",1024);
+
     //misc
     mReadOnlySytemHeader = boolValue("readonly_system_header",true);
     mAutoLoadLastFiles = boolValue("auto_load_last_files",true);
@@ -3698,6 +3727,26 @@ void Settings::Executor::setCaseMemoryLimit(size_t newCaseMemoryLimit)
     mCaseMemoryLimit = newCaseMemoryLimit;
 }
 
+int Settings::Executor::caseRunningThreads() const
+{
+    return mCaseRunningThreads;
+}
+
+void Settings::Executor::setCaseRunningThreads(int newCaseRunningThreads)
+{
+    mCaseRunningThreads = newCaseRunningThreads;
+}
+
+double Settings::Executor::caseFloatTolerance() const
+{
+    return mCaseFloatTolerance;
+}
+
+void Settings::Executor::setCaseFloatTolerance(double newCaseFloatTolerance)
+{
+    mCaseFloatTolerance = newCaseFloatTolerance;
+}
+
 bool Settings::Executor::convertHTMLToTextForExpected() const
 {
     return mConvertHTMLToTextForExpected;
@@ -3790,6 +3839,8 @@ void Settings::Executor::doSave()
     saveValue("case_memory_limit",mCaseMemoryLimit);
     remove("case_timeout");
     saveValue("enable_case_limit", mEnableCaseLimit);
+    saveValue("case_running_threads", mCaseRunningThreads);
+    saveValue("case_float_tolerance", mCaseFloatTolerance);
 }
 
 bool Settings::Executor::pauseConsole() const
@@ -3838,6 +3889,8 @@ void Settings::Executor::doLoad()
     if (boolValue("enable_time_limit", true)) {
         mEnableCaseLimit=true;
     }
+    mCaseRunningThreads = intValue("case_running_threads", std::max(1,QThread::idealThreadCount()));
+    mCaseFloatTolerance = doubleValue("case_float_tolerance", 0);
 }
 
 
@@ -4126,6 +4179,16 @@ void Settings::CodeCompletion::setShareParser(bool newShareParser)
     mShareParser = newShareParser;
 }
 
+bool Settings::CodeCompletion::cacheSystemHeaders() const
+{
+    return mCacheSystemHeaders;
+}
+
+void Settings::CodeCompletion::setCacheSystemHeaders(bool newCacheSystemHeaders)
+{
+    mCacheSystemHeaders = newCacheSystemHeaders;
+}
+
 bool Settings::CodeCompletion::hideSymbolsStartsWithUnderLine() const
 {
     return mHideSymbolsStartsWithUnderLine;
@@ -4265,6 +4328,7 @@ void Settings::CodeCompletion::doSave()
     saveValue("hide_symbols_start_with_two_underline", mHideSymbolsStartsWithTwoUnderLine);
     saveValue("hide_symbols_start_with_underline", mHideSymbolsStartsWithUnderLine);
     saveValue("share_parser",mShareParser);
+    saveValue("cache_system_headers",mCacheSystemHeaders);
 }
 
 
@@ -4317,6 +4381,7 @@ void Settings::CodeCompletion::doLoad()
 //#endif
     mClearWhenEditorHidden = boolValue("clear_when_editor_hidden",doClear);
     mShareParser = boolValue("share_parser",shouldShare);
+    mCacheSystemHeaders = boolValue("cache_system_headers",true);
 }
 
 Settings::CodeFormatter::CodeFormatter(Settings *settings):
@@ -310,6 +310,12 @@ public:
         bool enableAutolink() const;
         void setEnableAutolink(bool newEnableAutolink);
 
+        bool enableCompileCache() const;
+        void setEnableCompileCache(bool newEnableCompileCache);
+
+        int compileCacheMaxSize() const;
+        void setCompileCacheMaxSize(int newCompileCacheMaxSize);
+
         bool showRightEdgeLine() const;
         void setShowRightEdgeLine(bool newShowRightMarginLine);
 
@@ -513,6 +519,10 @@ public:
         //auto link
         bool mEnableAutolink;
 
+        //compile cache
+        bool mEnableCompileCache;
+        int mCompileCacheMaxSize; // MB
+
         //Misc
         QByteArray mDefaultEncoding;
         bool mAutoDetectFileEncoding;
@@ -668,6 +678,9 @@ public:
         bool shareParser();
         void setShareParser(bool newShareParser);
 
+        bool cacheSystemHeaders() const;
+        void setCacheSystemHeaders(bool newCacheSystemHeaders);
+
     private:
         int mWidth;
         int mHeight;
@@ -686,6 +699,7 @@ public:
         bool mHideSymbolsStartsWithUnderLine;
         bool mClearWhenEditorHidden;
         bool mShareParser;
+        bool mCacheSystemHeaders;
 
         // _Base interface
     protected:
@@ -925,6 +939,12 @@ public:
         size_t caseMemoryLimit() const;
         void setCaseMemoryLimit(size_t newCaseMemoryLimit);
 
+        int caseRunningThreads() const;
+        void setCaseRunningThreads(int newCaseRunningThreads);
+
+        double caseFloatTolerance() const;
+        void setCaseFloatTolerance(double newCaseFloatTolerance);
+
         bool convertHTMLToTextForInput() const;
         void setConvertHTMLToTextForInput(bool newConvertHTMLToTextForInput);
 
@@ -953,6 +973,8 @@ public:
         bool mEnableCaseLimit;
         qulonglong mCaseTimeout; //ms
         qulonglong mCaseMemoryLimit; //kb
+        int mCaseRunningThreads;
+        double mCaseFloatTolerance; // 0 means compare numbers as text
 
     protected:
         void doSave() override;
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "compilercachewidget.h"
+#include "ui_compilercachewidget.h"
+#include "../settings.h"
+#include "../utils.h"
+
+#include <QDir>
+#include <QLocale>
+
+CompilerCacheWidget::CompilerCacheWidget(const QString &name, const QString &group, QWidget *parent) :
+    SettingsWidget(name,group,parent),
+    ui(new Ui::CompilerCacheWidget)
+{
+    ui->setupUi(this);
+}
+
+CompilerCacheWidget::~CompilerCacheWidget()
+{
+    delete ui;
+}
+
+void CompilerCacheWidget::updateStats()
+{
+    qint64 hits, misses, size;
+    readCompileCacheStats(hits, misses, size);
+    ui->lblStats->setText(tr("%1 hits, %2 misses, %3 used")
+                          .arg(hits)
+                          .arg(misses)
+                          .arg(QLocale::system().formattedDataSize(size)));
+}
+
+void CompilerCacheWidget::doLoad()
+{
+    ui->grpCompileCache->setChecked(pSettings->editor().enableCompileCache());
+    ui->spinMaxSize->setValue(pSettings->editor().compileCacheMaxSize());
+    updateStats();
+}
+
+void CompilerCacheWidget::doSave()
+{
+    pSettings->editor().setEnableCompileCache(ui->grpCompileCache->isChecked());
+    pSettings->editor().setCompileCacheMaxSize(ui->spinMaxSize->value());
+    pSettings->editor().save();
+}
+
+void CompilerCacheWidget::on_btnClearCache_clicked()
+{
+    QDir(compileCacheDir()).removeRecursively();
+    updateStats();
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COMPILERCACHEWIDGET_H
+#define COMPILERCACHEWIDGET_H
+
+#include "settingswidget.h"
+
+namespace Ui {
+class CompilerCacheWidget;
+}
+
+class CompilerCacheWidget : public SettingsWidget
+{
+    Q_OBJECT
+
+public:
+    explicit CompilerCacheWidget(const QString& name, const QString& group, QWidget *parent = nullptr);
+    ~CompilerCacheWidget();
+
+private:
+    void updateStats();
+private:
+    Ui::CompilerCacheWidget *ui;
+
+    // SettingsWidget interface
+protected:
+    void doLoad() override;
+    void doSave() override;
+private slots:
+    void on_btnClearCache_clicked();
+};
+
+#endif // COMPILERCACHEWIDGET_H
@@ -55,6 +55,7 @@ void EditorCodeCompletionWidget::doLoad()
     ui->chkHideSymbolsStartWithUnderline->setChecked(pSettings->codeCompletion().hideSymbolsStartsWithUnderLine());
 
     ui->chkEditorShareCodeParser->setChecked(pSettings->codeCompletion().shareParser());
+    ui->chkCacheSystemHeaders->setChecked(pSettings->codeCompletion().cacheSystemHeaders());
     ui->spinMinCharRequired->setValue(pSettings->codeCompletion().minCharRequired());
 }
 
@@ -84,6 +85,7 @@ void EditorCodeCompletionWidget::doSave()
     pSettings->codeCompletion().setHideSymbolsStartsWithUnderLine(ui->chkHideSymbolsStartWithUnderline->isChecked());
 
     pSettings->codeCompletion().setShareParser(ui->chkEditorShareCodeParser->isChecked());
+    pSettings->codeCompletion().setCacheSystemHeaders(ui->chkCacheSystemHeaders->isChecked());
 
     pSettings->codeCompletion().save();
 }
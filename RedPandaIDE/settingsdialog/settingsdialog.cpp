@@ -19,6 +19,7 @@
 #include "settingswidget.h"
 #include "compilersetoptionwidget.h"
 #include "compilerautolinkwidget.h"
+#include "compilercachewidget.h"
 #include "editorgeneralwidget.h"
 #include "editorfontwidget.h"
 #include "editorclipboardwidget.h"
@@ -171,6 +172,9 @@ PSettingsDialog SettingsDialog::optionDialog()
     widget = new CompilerAutolinkWidget(tr("Auto Link"),tr("Compiler"));
     dialog->addWidget(widget);
 
+    widget = new CompilerCacheWidget(tr("Compile Cache"),tr("Compiler"));
+    dialog->addWidget(widget);
+
     widget = new EditorGeneralWidget(tr("General"),tr("Editor"));
     dialog->addWidget(widget);
 
@@ -22,6 +22,7 @@
 #define APP_SETTSINGS_FILENAME "redpandacpp.ini"
 #ifdef Q_OS_WIN
 #define CONSOLE_PAUSER  "consolepauser.exe"
+#define COMPILE_CACHE_PROGRAM  "redpanda-compile-cache.exe"
 #define ASSEMBLER   "nasm.exe"
 #define GCC_PROGRAM     "gcc.exe"
 #define GPP_PROGRAM     "g++.exe"
@@ -39,6 +40,7 @@
 #define LLDB_SERVER_PROGRAM   "lldb-server.exe"
 #elif defined(Q_OS_LINUX)
 #define CONSOLE_PAUSER  "consolepauser"
+#define COMPILE_CACHE_PROGRAM  "redpanda-compile-cache"
 #define ASSEMBLER   "nasm"
 #define GCC_PROGRAM     "gcc"
 #define GPP_PROGRAM     "g++"
@@ -56,6 +58,7 @@
 #define LLDB_MI_PROGRAM   "lldb-mi"
 #define LLDB_SERVER_PROGRAM   "lldb-server"
 #elif defined(Q_OS_MACOS)
+#define COMPILE_CACHE_PROGRAM  "redpanda-compile-cache"
 #define ASSEMBLER   "nasm"
 #define GCC_PROGRAM     "gcc"
 #define GPP_PROGRAM     "g++"
@@ -99,6 +102,10 @@
 #define DEV_SHORTCUT_FILE "shortcuts.json"
 #define DEV_TOOLS_FILE "tools.json"
 #define DEV_BOOKMARK_FILE "bookmarks.json"
+#define DEV_PARSER_CACHE_DIR "parsercache"
+#define DEV_PCH_CACHE_DIR "RedPandaCppPCH"
+#define DEV_COMPILE_CACHE_DIR "compilecache"
+#define COMPILE_CACHE_STATS_FILE "stats"
 #define DEV_DEBUGGER_FILE "debugger.json"
 #define DEV_HISTORY_FILE "history.json"
 #define DEV_PROBLEM_SET_FILE "problemset.json"
@@ -331,6 +331,10 @@ void resetCppParser(std::shared_ptr<CppParser> parser, int compilerSetIndex)
         parser->addHardDefineByLine("#define __DATE__  1");
         parser->addHardDefineByLine("#define __TIME__  1");
     }
+    if (pSettings->codeCompletion().cacheSystemHeaders())
+        parser->setSystemHeaderCacheDir(includeTrailingPathDelimiter(pSettings->dirs().config())+DEV_PARSER_CACHE_DIR);
+    else
+        parser->setSystemHeaderCacheDir("");
     parser->parseHardDefines();
     pMainWindow->disconnect(parser.get(),
                             &CppParser::onStartParsing,
@@ -358,6 +362,28 @@ void resetCppParser(std::shared_ptr<CppParser> parser, int compilerSetIndex)
                             &MainWindow::onEndParsing);
 }
 
+QString compileCacheDir()
+{
+    return includeTrailingPathDelimiter(pSettings->dirs().config())+DEV_COMPILE_CACHE_DIR;
+}
+
+void readCompileCacheStats(qint64 &hits, qint64 &misses, qint64 &size)
+{
+    //the stats file is written by the compile cache program as "<hits> <misses> <size>"
+    hits = 0;
+    misses = 0;
+    size = 0;
+    QFile file(includeTrailingPathDelimiter(compileCacheDir())+COMPILE_CACHE_STATS_FILE);
+    if (!file.open(QFile::ReadOnly))
+        return;
+    QList<QByteArray> values = file.readAll().simplified().split(' ');
+    if (values.count()>=3) {
+        hits = values[0].toLongLong();
+        misses = values[1].toLongLong();
+        size = values[2].toLongLong();
+    }
+}
+
 int getNewFileNumber()
 {
     static int count = 0;
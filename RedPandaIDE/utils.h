@@ -117,6 +117,9 @@ QString parseMacros(const QString& s);
 class CppParser;
 void resetCppParser(std::shared_ptr<CppParser> parser, int compilerSetIndex=-1);
 
+QString compileCacheDir();
+void readCompileCacheStats(qint64& hits, qint64& misses, qint64& size);
+
 int getNewFileNumber();
 
 QByteArray runAndGetOutput(const QString& cmd, const QString& workingDir, const QStringList& arguments,
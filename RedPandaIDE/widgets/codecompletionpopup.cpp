@@ -157,7 +157,7 @@ bool CodeCompletionPopup::search(const QString &memberPhrase, bool autoHideOnSin
         // if only one suggestion and auto hide , don't show the frame
         if(mCompletionStatementList.count() == 1)
             if (autoHideOnSingleResult
-                    || (memberPhrase == mCompletionStatementList.front()->command)) {
+                    || (memberPhrase == mCompletionStatementList.front().statement->command)) {
             return true;
         }
     } else {
@@ -172,10 +172,10 @@ PStatement CodeCompletionPopup::selectedStatement()
         int index = mListView->currentIndex().row();
         if (mListView->currentIndex().isValid()
                 && (index<mCompletionStatementList.count()) ) {
-            return mCompletionStatementList[index];
+            return mCompletionStatementList[index].statement;
         } else {
             if (!mCompletionStatementList.isEmpty())
-                return mCompletionStatementList.front();
+                return mCompletionStatementList.front().statement;
             else
                 return PStatement();
         }
@@ -266,15 +266,17 @@ static bool nameComparator(PStatement statement1,PStatement statement2) {
     return statement1->command < statement2->command;
 }
 
-static bool defaultComparator(PStatement statement1,PStatement statement2) {
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool defaultComparator(const CodeCompletionItem& item1,const CodeCompletionItem& item2) {
+    const PStatement& statement1 = item1.statement;
+    const PStatement& statement2 = item2.statement;
+    if (item1.matchPosSpan!=item2.matchPosSpan)
+        return item1.matchPosSpan < item2.matchPosSpan;
+    if (item1.firstMatchLength != item2.firstMatchLength)
+        return item1.firstMatchLength > item2.firstMatchLength;
+    if (item1.matchPosTotal != item2.matchPosTotal)
+        return item1.matchPosTotal < item2.matchPosTotal;
+    if (item1.caseMatched != item2.caseMatched)
+        return item1.caseMatched > item2.caseMatched;
     // Show user template first
     if (statement1->kind == StatementKind::skUserCodeSnippet) {
         if (statement2->kind != StatementKind::skUserCodeSnippet)
@@ -294,15 +296,17 @@ static bool defaultComparator(PStatement statement1,PStatement statement2) {
         return nameComparator(statement1,statement2);
 }
 
-static bool sortByScopeComparator(PStatement statement1,PStatement statement2){
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool sortByScopeComparator(const CodeCompletionItem& item1,const CodeCompletionItem& item2) {
+    const PStatement& statement1 = item1.statement;
+    const PStatement& statement2 = item2.statement;
+    if (item1.matchPosSpan!=item2.matchPosSpan)
+        return item1.matchPosSpan < item2.matchPosSpan;
+    if (item1.firstMatchLength != item2.firstMatchLength)
+        return item1.firstMatchLength > item2.firstMatchLength;
+    if (item1.matchPosTotal != item2.matchPosTotal)
+        return item1.matchPosTotal < item2.matchPosTotal;
+    if (item1.caseMatched != item2.caseMatched)
+        return item1.caseMatched > item2.caseMatched;
     // Show user template first
     if (statement1->kind == StatementKind::skUserCodeSnippet) {
         if (statement2->kind != StatementKind::skUserCodeSnippet)
@@ -338,15 +342,17 @@ static bool sortByScopeComparator(PStatement statement1,PStatement statement2){
         return nameComparator(statement1,statement2);
 }
 
-static bool sortWithUsageComparator(PStatement statement1,PStatement statement2) {
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool sortWithUsageComparator(const CodeCompletionItem& item1,const CodeCompletionItem& item2) {
+    const PStatement& statement1 = item1.statement;
+    const PStatement& statement2 = item2.statement;
+    if (item1.matchPosSpan!=item2.matchPosSpan)
+        return item1.matchPosSpan < item2.matchPosSpan;
+    if (item1.firstMatchLength != item2.firstMatchLength)
+        return item1.firstMatchLength > item2.firstMatchLength;
+    if (item1.matchPosTotal != item2.matchPosTotal)
+        return item1.matchPosTotal < item2.matchPosTotal;
+    if (item1.caseMatched != item2.caseMatched)
+        return item1.caseMatched > item2.caseMatched;
     // Show user template first
     if (statement1->kind == StatementKind::skUserCodeSnippet) {
         if (statement2->kind != StatementKind::skUserCodeSnippet)
@@ -357,8 +363,8 @@ static bool sortWithUsageComparator(PStatement statement1,PStatement statement2)
         return false;
         //show most freq first
     }
-    if (statement1->usageCount != statement2->usageCount)
-        return statement1->usageCount > statement2->usageCount;
+    if (item1.usageCount != item2.usageCount)
+        return item1.usageCount > item2.usageCount;
 
     if ((statement1->kind != StatementKind::skKeyword)
                && (statement2->kind == StatementKind::skKeyword)) {
@@ -370,15 +376,17 @@ static bool sortWithUsageComparator(PStatement statement1,PStatement statement2)
         return nameComparator(statement1,statement2);
 }
 
-static bool sortByScopeWithUsageComparator(PStatement statement1,PStatement statement2){
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool sortByScopeWithUsageComparator(const CodeCompletionItem& item1,const CodeCompletionItem& item2) {
+    const PStatement& statement1 = item1.statement;
+    const PStatement& statement2 = item2.statement;
+    if (item1.matchPosSpan!=item2.matchPosSpan)
+        return item1.matchPosSpan < item2.matchPosSpan;
+    if (item1.firstMatchLength != item2.firstMatchLength)
+        return item1.firstMatchLength > item2.firstMatchLength;
+    if (item1.matchPosTotal != item2.matchPosTotal)
+        return item1.matchPosTotal < item2.matchPosTotal;
+    if (item1.caseMatched != item2.caseMatched)
+        return item1.caseMatched > item2.caseMatched;
     // Show user template first
     if (statement1->kind == StatementKind::skUserCodeSnippet) {
         if (statement2->kind != StatementKind::skUserCodeSnippet)
@@ -389,8 +397,8 @@ static bool sortByScopeWithUsageComparator(PStatement statement1,PStatement stat
         return false;
         //show most freq first
     }
-    if (statement1->usageCount != statement2->usageCount)
-        return statement1->usageCount > statement2->usageCount;
+    if (item1.usageCount != item2.usageCount)
+        return item1.usageCount > item2.usageCount;
 
         // show non-system defines before keyword
     if (statement1->kind == StatementKind::skKeyword) {
@@ -443,7 +451,7 @@ void CodeCompletionPopup::filterList(const QString &member)
         int pos = 0;
         int lastPos = -10;
         int totalPos = 0;
-        statement->matchPositions.clear();
+        QList<PStatementMathPosition> matchPositions;
         if (hideSymbolsTwoUnderline && statement->command.startsWith("__")) {
             continue;
         } else if (hideSymbolsUnderline && statement->command.startsWith("_")) {
@@ -458,12 +466,12 @@ void CodeCompletionPopup::filterList(const QString &member)
                     break;
                 }
                 if (pos == lastPos+1) {
-                    statement->matchPositions.last()->end++;
+                    matchPositions.last()->end++;
                 } else {
                     PStatementMathPosition matchPosition=std::make_shared<StatementMatchPosition>();
                     matchPosition->start = pos;
                     matchPosition->end = pos+1;
-                    statement->matchPositions.append(matchPosition);
+                    matchPositions.append(matchPosition);
                 }
                 if (ch==command[pos])
                     caseMatched++;
@@ -474,44 +482,35 @@ void CodeCompletionPopup::filterList(const QString &member)
             }
         }
 
-        if (mIgnoreCase && matched== len) {
-            statement->caseMatched = caseMatched;
-            statement->matchPosTotal = totalPos;
+        if ((mIgnoreCase && matched== len) || caseMatched == len) {
+            CodeCompletionItem item;
+            item.statement = statement;
+            item.usageCount = 0;
+            item.caseMatched = caseMatched;
+            item.matchPosTotal = totalPos;
             if (member.length()>0) {
-                statement->firstMatchLength = statement->matchPositions.front()->end - statement->matchPositions.front()->start;
-                statement->matchPosSpan = statement->matchPositions.last()->end - statement->matchPositions.front()->start;
-            } else
-                statement->firstMatchLength = 0;
-            mCompletionStatementList.append(statement);
-        } else if (caseMatched == len) {
-            statement->caseMatched = caseMatched;
-            statement->matchPosTotal = totalPos;
-            if (member.length()>0) {
-                statement->firstMatchLength = statement->matchPositions.front()->end - statement->matchPositions.front()->start;
-                statement->matchPosSpan = statement->matchPositions.last()->end - statement->matchPositions.front()->start;
-            } else
-                statement->firstMatchLength = 0;
-            mCompletionStatementList.append(statement);
-        } else {
-            statement->matchPositions.clear();
-            statement->caseMatched = 0;
-            statement->matchPosTotal = 0;
-            statement->firstMatchLength = 0;
-            statement->matchPosSpan = 0;
+                item.firstMatchLength = matchPositions.front()->end - matchPositions.front()->start;
+                item.matchPosSpan = matchPositions.last()->end - matchPositions.front()->start;
+            } else {
+                item.firstMatchLength = 0;
+                item.matchPosSpan = 0;
+            }
+            item.matchPositions = matchPositions;
+            mCompletionStatementList.append(item);
         }
     }
     if (mRecordUsage) {
-        int usageCount;
-        foreach (const PStatement& statement,mCompletionStatementList) {
-            if (statement->usageCount == -1) {
-                PSymbolUsage usage = pMainWindow->symbolUsageManager()->findUsage(statement->fullName);
-                if (usage) {
-                    usageCount = usage->count;
-                } else {
-                    usageCount = 0;
-                }
-                statement->usageCount = usageCount;
+        for (CodeCompletionItem& item:mCompletionStatementList) {
+            //keywords and code snippets are not counted
+            if (item.statement->kind == StatementKind::skKeyword
+                    || item.statement->kind == StatementKind::skUserCodeSnippet)
+                continue;
+            QHash<QString,int>::const_iterator it = mUsageCounts.constFind(item.statement->fullName);
+            if (it == mUsageCounts.constEnd()) {
+                PSymbolUsage usage = pMainWindow->symbolUsageManager()->findUsage(item.statement->fullName);
+                it = mUsageCounts.insert(item.statement->fullName, usage?usage->count:0);
             }
+            item.usageCount = it.value();
         }
         if (mSortByScope) {
             std::sort(mCompletionStatementList.begin(),
@@ -587,7 +586,6 @@ void CodeCompletionPopup::getCompletionFor(
                     statement->value = codeIn->code;
                     statement->kind = StatementKind::skUserCodeSnippet;
                     statement->fullName = codeIn->prefix;
-                    statement->usageCount = 0;
                     mFullCompletionStatementList.append(statement);
                 }
             }
@@ -952,7 +950,6 @@ void CodeCompletionPopup::addKeyword(const QString &keyword)
     statement->command = keyword;
     statement->kind = StatementKind::skKeyword;
     statement->fullName = keyword;
-    statement->usageCount = 0;
     mFullCompletionStatementList.append(statement);
 }
 
@@ -1105,6 +1102,7 @@ void CodeCompletionPopup::hideEvent(QHideEvent *event)
 //        statement->matchPositions.clear();
 //    }
     mFullCompletionStatementList.clear();
+    mUsageCounts.clear();
     mIncludedFiles.clear();
     mUsings.clear();
     mAddedStatements.clear();
@@ -1123,32 +1121,32 @@ bool CodeCompletionPopup::event(QEvent *event)
     return result;
 }
 
-CodeCompletionListModel::CodeCompletionListModel(const StatementList *statements, QObject *parent):
+CodeCompletionListModel::CodeCompletionListModel(const CodeCompletionItemList *items, QObject *parent):
     QAbstractListModel(parent),
-    mStatements(statements)
+    mItems(items)
 {
 
 }
 
 int CodeCompletionListModel::rowCount(const QModelIndex &) const
 {
-    return mStatements->count();
+    return mItems->count();
 }
 
 QVariant CodeCompletionListModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid())
         return QVariant();
-    if (index.row()>=mStatements->count())
+    if (index.row()>=mItems->count())
         return QVariant();
 
     switch(role) {
     case Qt::DisplayRole: {
-        PStatement statement = mStatements->at(index.row());
+        PStatement statement = mItems->at(index.row()).statement;
         return statement->command;
         }
     case Qt::DecorationRole:
-        PStatement statement = mStatements->at(index.row());
+        PStatement statement = mItems->at(index.row()).statement;
         return pIconsManager->getPixmapForStatement(statement);
     }
     return QVariant();
@@ -1158,18 +1156,27 @@ PStatement CodeCompletionListModel::statement(const QModelIndex &index) const
 {
     if (!index.isValid())
         return PStatement();
-    if (index.row()>=mStatements->count())
+    if (index.row()>=mItems->count())
         return PStatement();
-    return mStatements->at(index.row());
+    return mItems->at(index.row()).statement;
+}
+
+QList<PStatementMathPosition> CodeCompletionListModel::matchPositions(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return QList<PStatementMathPosition>();
+    if (index.row()>=mItems->count())
+        return QList<PStatementMathPosition>();
+    return mItems->at(index.row()).matchPositions;
 }
 
 QPixmap CodeCompletionListModel::statementIcon(const QModelIndex &index) const
 {
     if (!index.isValid())
         return QPixmap();
-    if (index.row()>=mStatements->count())
+    if (index.row()>=mItems->count())
         return QPixmap();
-    PStatement statement = mStatements->at(index.row());
+    PStatement statement = mItems->at(index.row()).statement;
     return pIconsManager->getPixmapForStatement(statement);
 }
 
@@ -1199,7 +1206,7 @@ void CodeCompletionListItemDelegate::paint(QPainter *painter, const QStyleOption
         QString text = statement->command;
         int pos=0;
         int y=option.rect.bottom()-painter->fontMetrics().descent();
-        foreach (const PStatementMathPosition& matchPosition, statement->matchPositions) {
+        foreach (const PStatementMathPosition& matchPosition, mModel->matchPositions(index)) {
             if (pos<matchPosition->start) {
                 QString t = text.mid(pos,matchPosition->start-pos);
                 painter->setPen(normalColor);
@@ -23,18 +23,32 @@
 #include "codecompletionlistview.h"
 
 class ColorSchemeItem;
+
+// a statement in the completion list and how it matches the typed phrase
+struct CodeCompletionItem {
+    PStatement statement;
+    int usageCount; //Usage Count
+    int matchPosTotal; // total of matched positions
+    int matchPosSpan; // distance between the first match pos and the last match pos;
+    int firstMatchLength; // length of first match;
+    int caseMatched; // if match with case
+    QList<PStatementMathPosition> matchPositions;
+};
+using CodeCompletionItemList = QVector<CodeCompletionItem>;
+
 class CodeCompletionListModel : public QAbstractListModel {
     Q_OBJECT
 public:
-    explicit CodeCompletionListModel(const StatementList* statements,QObject *parent = nullptr);
+    explicit CodeCompletionListModel(const CodeCompletionItemList* items,QObject *parent = nullptr);
     int rowCount(const QModelIndex &parent) const override;
     QVariant data(const QModelIndex &index, int role) const override;
     PStatement statement(const QModelIndex &index) const;
+    QList<PStatementMathPosition> matchPositions(const QModelIndex &index) const;
     QPixmap statementIcon(const QModelIndex &index) const;
     void notifyUpdated();
 
 private:
-    const StatementList* mStatements;
+    const CodeCompletionItemList* mItems;
 };
 
 enum class CodeCompletionType {
@@ -163,7 +177,8 @@ private:
     QList<PCodeSnippet> mCodeSnippets; //(Code template list)
     //QList<PStatement> mCodeInsStatements; //temporary (user code template) statements created when show code suggestion
     StatementList mFullCompletionStatementList;
-    StatementList mCompletionStatementList;
+    CodeCompletionItemList mCompletionStatementList;
+    QHash<QString,int> mUsageCounts; // symbol usage counts looked up when filtering
     QSet<QString> mIncludedFiles;
     QSet<QString> mUsings;
     QSet<QString> mAddedStatements;
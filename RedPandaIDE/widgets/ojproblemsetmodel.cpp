@@ -502,7 +502,7 @@ QVariant OJProblemModel::data(const QModelIndex &index, int role) const
                  return "";
         }
         break;
-#ifdef Q_OS_WIN
+#if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
     case 2:
         if (role == Qt::DisplayRole) {
              POJProblemCase problemCase = mProblem->cases[index.row()];
@@ -550,7 +550,7 @@ Qt::ItemFlags OJProblemModel::flags(const QModelIndex &idx) const
 
 int OJProblemModel::columnCount(const QModelIndex &/*parent*/) const
 {
-#ifdef Q_OS_WIN
+#if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
     return 3;
 #else
     return 2;
@@ -565,7 +565,7 @@ QVariant OJProblemModel::headerData(int section, Qt::Orientation orientation, in
             return tr("Name");
         case 1:
             return tr("Time(ms)");
-#ifdef Q_OS_WIN
+#if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
         case 2:
             return tr("Memory(kb)");
 #endif
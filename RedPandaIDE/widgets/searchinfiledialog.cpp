@@ -20,13 +20,11 @@
 #include "../editor.h"
 #include "../mainwindow.h"
 #include "../editorlist.h"
-#include <qsynedit/searcher/basicsearcher.h>
-#include <qsynedit/searcher/regexsearcher.h>
 #include "../project.h"
 #include "../settings.h"
+#include "../filesearcher.h"
 #include <QMessageBox>
 #include <QDebug>
-#include <QProgressDialog>
 
 
 SearchInFileDialog::SearchInFileDialog(QWidget *parent) :
@@ -36,12 +34,16 @@ SearchInFileDialog::SearchInFileDialog(QWidget *parent) :
     setWindowFlag(Qt::WindowContextHelpButtonHint,false);
     ui->setupUi(this);
     mSearchOptions&=0;
-    mBasicSearchEngine= QSynedit::PSynSearchBase(new QSynedit::BasicSearcher());
-    mRegexSearchEngine= QSynedit::PSynSearchBase(new QSynedit::RegexSearcher());
+    mSearcher = nullptr;
 }
 
 SearchInFileDialog::~SearchInFileDialog()
 {
+    if (mSearcher) {
+        mSearcher->stop();
+        mSearcher->wait();
+        delete mSearcher;
+    }
     delete ui;
 }
 
@@ -94,7 +96,6 @@ void SearchInFileDialog::on_btnExecute_clicked()
 
 void SearchInFileDialog::doSearch(bool replace)
 {
-    int findCount = 0;
     saveComboHistory(ui->cbFind,ui->cbFind->currentText());
 
     mSearchOptions&=0;
@@ -114,185 +115,93 @@ void SearchInFileDialog::doSearch(bool replace)
 
     close();
 
-    // Find the first one, then quit
-    int fileSearched = 0;
-    int fileHitted = 0;
     QString keyword = ui->cbFind->currentText();
+    SearchFileScope scope;
     if (ui->rbOpenFiles->isChecked()) {
-        PSearchResults results = pMainWindow->searchResultModel()->addSearchResults(
-                    keyword,
-                    mSearchOptions,
-                    SearchFileScope::openedFiles
-                    );
-        // loop through editors, add results to message control
-        for (int i=0;i<pMainWindow->editorList()->pageCount();i++) {
-            Editor * e=pMainWindow->editorList()->operator[](i);
-            if (e!=nullptr) {
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            e,
-                            e->filename(),
-                            keyword);
-                int t = parentItem->results.size();
-                findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            }
-        }
-        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+        scope = SearchFileScope::openedFiles;
     } else if (ui->rbCurrentFile->isChecked()) {
-        PSearchResults results = pMainWindow->searchResultModel()->addSearchResults(
-                    keyword,
-                    mSearchOptions,
-                    SearchFileScope::currentFile
-                    );
-        Editor * e= pMainWindow->editorList()->getEditor();
-        if (e!=nullptr) {
-            fileSearched++;
-            PSearchResultTreeItem parentItem = batchFindInEditor(
-                        e,
-                        e->filename(),
-                        keyword);
-            int t = parentItem->results.size();
-            findCount+=t;
-            if (t>0) {
-                fileHitted++;
-                results->results.append(parentItem);
-            }
-        }
-        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+        scope = SearchFileScope::currentFile;
     } else if (ui->rbProject->isChecked()) {
         if (!pMainWindow->project())
             return;
-        PSearchResults results = pMainWindow->searchResultModel()->addSearchResults(
-                    keyword,
-                    mSearchOptions,
-                    SearchFileScope::wholeProject
-                    );
+        scope = SearchFileScope::wholeProject;
+    } else
+        return;
+
+    stopSearch();
+    PSearchResults results = pMainWindow->searchResultModel()->addSearchResults(
+                keyword,
+                mSearchOptions,
+                scope
+                );
+    //editor contents are copied here, files on disk are read by the searcher
+    FileSearcher* searcher = new FileSearcher(keyword, mSearchOptions);
+    switch(scope) {
+    case SearchFileScope::openedFiles:
+        for (int i=0;i<pMainWindow->editorList()->pageCount();i++) {
+            Editor * e=pMainWindow->editorList()->operator[](i);
+            if (e!=nullptr)
+                searcher->addFile(e->filename(), e->contents());
+        }
+        break;
+    case SearchFileScope::currentFile: {
+        Editor * e= pMainWindow->editorList()->getEditor();
+        if (e!=nullptr)
+            searcher->addFile(e->filename(), e->contents());
+    }
+        break;
+    case SearchFileScope::wholeProject: {
         QByteArray projectEncoding = pMainWindow->project()->options().encoding;
-        QProgressDialog progressDlg(
-                    tr("Searching..."),
-                    tr("Abort"),
-                    0,
-                    pMainWindow->project()->unitList().count(),
-                    pMainWindow);
-
-        progressDlg.setWindowModality(Qt::WindowModal);
-        int i=0;
         foreach (PProjectUnit unit, pMainWindow->project()->unitList()) {
-            i++;
-            progressDlg.setValue(i);
-            progressDlg.setLabelText(tr("Searching...")+"<br/>"+unit->fileName());
-
-            if (progressDlg.wasCanceled())
-                break;
             Editor * e = pMainWindow->project()->unitEditor(unit);
             QString curFilename =  unit->fileName();
             if (e) {
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            e,
-                            e->filename(),
-                            keyword);
-                int t = parentItem->results.size();
-                findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
+                searcher->addFile(e->filename(), e->contents());
             } else if (fileExists(curFilename)) {
-                QSynedit::QSynEdit editor;
                 QByteArray encoding=unit->encoding();
                 if (encoding==ENCODING_PROJECT)
                     encoding = projectEncoding;
-                QByteArray realEncoding;
-                editor.document()->loadFromFile(curFilename,encoding, realEncoding);
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            &editor,
-                            curFilename,
-                            keyword);
-                int t = parentItem->results.size();
-                findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
+                searcher->addFile(curFilename, encoding);
             }
         }
-        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
     }
-    pMainWindow->showSearchPanel(replace);
-
-}
-
-int SearchInFileDialog::execute(QSynedit::QSynEdit *editor, const QString &sSearch, const QString &sReplace,
-                          QSynedit::SearchMathedProc matchCallback,
-                          QSynedit::SearchConfirmAroundProc confirmAroundCallback)
-{
-    if (editor==nullptr)
-        return 0;
-    // Modify the caret when using 'from cursor' and when the selection is ignored
-    if (!mSearchOptions.testFlag(QSynedit::ssoEntireScope) && !mSearchOptions.testFlag(QSynedit::ssoSelectedOnly)
-            && editor->selAvail()) {
-        // start at end of selection
-        if (mSearchOptions.testFlag(QSynedit::ssoBackwards)) {
-            editor->setCaretXY(editor->blockBegin());
-        } else {
-            editor->setCaretXY(editor->blockEnd());
-        }
-    }
-
-    QSynedit::PSynSearchBase searchEngine;
-    if (mSearchOptions.testFlag(QSynedit::ssoRegExp)) {
-        searchEngine = mRegexSearchEngine;
-    } else {
-        searchEngine = mBasicSearchEngine;
+        break;
     }
-
-    return editor->searchReplace(sSearch, sReplace, mSearchOptions,
-                          searchEngine, matchCallback, confirmAroundCallback);
+    connect(searcher, &FileSearcher::resultsFound,
+            this, [results](PSearchResultTreeItemList items){
+        results->results.append(*items);
+        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+    });
+    connect(searcher, &FileSearcher::progress,
+            this, [this](int searched, int total){
+        pMainWindow->updateStatusbarMessage(tr("Searching... %1/%2").arg(searched).arg(total));
+    });
+    connect(searcher, &QThread::finished,
+            this, [this,searcher](){
+        if (mSearcher == searcher) {
+            mSearcher = nullptr;
+            pMainWindow->setSearchInFilesRunning(false);
+        }
+    });
+    connect(searcher, &QThread::finished,
+            searcher, &QObject::deleteLater);
+    mSearcher = searcher;
+    pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+    pMainWindow->showSearchPanel(replace);
+    pMainWindow->setSearchInFilesRunning(true);
+    searcher->start();
 }
 
-std::shared_ptr<SearchResultTreeItem> SearchInFileDialog::batchFindInEditor(QSynedit::QSynEdit *e, const QString& filename,const QString &keyword)
+void SearchInFileDialog::stopSearch()
 {
-    //backup
-    QSynedit::BufferCoord caretBackup = e->caretXY();
-    QSynedit::BufferCoord blockBeginBackup = e->blockBegin();
-    QSynedit::BufferCoord blockEndBackup = e->blockEnd();
-    int toplineBackup = e->topLine();
-    int leftCharBackup = e->leftChar();
-
-    PSearchResultTreeItem parentItem = std::make_shared<SearchResultTreeItem>();
-    parentItem->filename = filename;
-    parentItem->parent = nullptr;
-    execute(e,keyword,"",
-                    [e,&parentItem, filename](const QString&,
-                    const QString&, int Line, int ch, int wordLen){
-        PSearchResultTreeItem item = std::make_shared<SearchResultTreeItem>();
-        item->filename = filename;
-        item->line = Line;
-        item->start = ch;
-        item->len = wordLen;
-        item->parent = parentItem.get();
-        item->text = e->document()->getLine(Line-1);
-        item->text.replace('\t',' ');
-        parentItem->results.append(item);
-        return QSynedit::SearchAction::Skip;
-    });
-
-    // restore
-    e->setCaretXY(caretBackup);
-    e->setTopLine(toplineBackup);
-    e->setLeftChar(leftCharBackup);
-    e->setCaretAndSelection(
-                caretBackup,
-                blockBeginBackup,
-                blockEndBackup
-                );
-    return parentItem;
+    if (!mSearcher)
+        return;
+    //results of the old search are no longer wanted
+    disconnect(mSearcher, &FileSearcher::resultsFound, this, nullptr);
+    disconnect(mSearcher, &FileSearcher::progress, this, nullptr);
+    mSearcher->stop();
+    mSearcher = nullptr;
+    pMainWindow->setSearchInFilesRunning(false);
 }
 
 void SearchInFileDialog::showEvent(QShowEvent *event)
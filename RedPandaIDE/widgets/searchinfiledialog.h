@@ -25,9 +25,9 @@ namespace Ui {
 class SearchInFileDialog;
 }
 
-struct SearchResultTreeItem;
 class QTabBar;
 class Editor;
+class FileSearcher;
 class SearchInFileDialog : public QDialog
 {
     Q_OBJECT
@@ -37,7 +37,7 @@ public:
     ~SearchInFileDialog();
     void findInFiles(const QString& text);
     void findInFiles(const QString& keyword, SearchFileScope scope, QSynedit::SearchOptions options);
-    QSynedit::PSynSearchBase searchEngine() const;
+    void stopSearch();
 
 private slots:
    void on_cbFind_currentTextChanged(const QString &arg1);
@@ -49,16 +49,10 @@ private slots:
 
 private:
    void doSearch(bool replace);
-   int execute(QSynedit::QSynEdit* editor, const QString& sSearch,
-               const QString& sReplace,
-               QSynedit::SearchMathedProc matchCallback = nullptr,
-               QSynedit::SearchConfirmAroundProc confirmAroundCallback = nullptr);
-   std::shared_ptr<SearchResultTreeItem> batchFindInEditor(QSynedit::QSynEdit * editor,const QString& filename, const QString& keyword);
 private:
     Ui::SearchInFileDialog *ui;
     QSynedit::SearchOptions mSearchOptions;
-    QSynedit::PSynSearchBase mBasicSearchEngine;
-    QSynedit::PSynSearchBase mRegexSearchEngine;
+    FileSearcher* mSearcher;
 
     // QWidget interface
 protected:
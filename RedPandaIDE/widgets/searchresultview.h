@@ -28,6 +28,7 @@ struct SearchResultTreeItem;
 using PSearchResultTreeItem = std::shared_ptr<SearchResultTreeItem>;
 using SearchResultTreeItemList = QList<PSearchResultTreeItem>;
 using PSearchResultTreeItemList = std::shared_ptr<SearchResultTreeItemList>;
+Q_DECLARE_METATYPE(PSearchResultTreeItemList);
 
 enum class SearchType {
     Search,
@@ -4,11 +4,13 @@ SUBDIRS += \
     RedPandaIDE \
     astyle \
     consolepauser \
+    redpanda-compile-cache \
     redpanda_qt_utils \
     qsynedit
     
 astyle.subdir = tools/astyle
 consolepauser.subdir = tools/consolepauser
+redpanda-compile-cache.subdir = tools/redpanda-compile-cache
 redpanda_qt_utils.subdir = libs/redpanda_qt_utils
 qsynedit.subdir = libs/qsynedit
 
@@ -18,7 +20,7 @@ APP_VERSION = 2.17
 
 # Add the dependencies so that the RedPandaIDE project can add the depended programs
 # into the main app bundle
-RedPandaIDE.depends = astyle consolepauser qsynedit
+RedPandaIDE.depends = astyle consolepauser redpanda-compile-cache qsynedit
 qsynedit.depends = redpanda_qt_utils
 
 win32: {
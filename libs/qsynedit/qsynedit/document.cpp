@@ -25,6 +25,7 @@
 #include "qsynedit.h"
 #include <QMessageBox>
 #include <cmath>
+#include <algorithm>
 #include "qt_utils/charsetinfo.h"
 #include <QDebug>
 
@@ -45,9 +46,14 @@ Document::Document(const QFont& font, const QFont& nonAsciiFont, QObject *parent
     mNewlineType = NewlineType::Windows;
     mIndexOfLongestLine = -1;
     mUpdateCount = 0;
+    mLargeFile = false;
     mCharWidth =  mFontMetrics.horizontalAdvance("M");
+    resetCharColumnsCache();
 }
 
+//files larger than this are loaded lazily
+static const qint64 LargeFileSize = 16*1024*1024;
+
 static void ListIndexOutOfBounds(int index) {
     throw IndexOutOfRange(index);
 }
@@ -130,7 +136,9 @@ int Document::lengthOfLongestLine() {
         mIndexOfLongestLine = -1;
         if (mLines.count() > 0 ) {
             for (int i=0;i<mLines.size();i++) {
-                int len = lineColumns(i);
+                //don't decode and measure lines not displayed yet, estimate by their sizes
+                const PDocumentLine& line = mLines[i];
+                int len = (line->rawStart>=0 && line->columns<0)? line->rawLength : lineColumns(i);
                 if (len > MaxLen) {
                     MaxLen = len;
                     mIndexOfLongestLine = i;
@@ -138,9 +146,10 @@ int Document::lengthOfLongestLine() {
             }
         }
     }
-    if (mIndexOfLongestLine >= 0)
-        return mLines[mIndexOfLongestLine]->columns;
-    else
+    if (mIndexOfLongestLine >= 0) {
+        const PDocumentLine& line = mLines[mIndexOfLongestLine];
+        return (line->columns<0)? line->rawLength : line->columns;
+    } else
         return 0;
 }
 
@@ -217,7 +226,7 @@ QString Document::getLine(int Index)
     if (Index<0 || Index>=mLines.count()) {
         return QString();
     }
-    return mLines[Index]->lineText;
+    return lineText(mLines[Index]);
 }
 
 int Document::count()
@@ -261,9 +270,9 @@ QStringList Document::contents()
 {
     QMutexLocker locker(&mMutex);
     QStringList result;
-    DocumentLines list = mLines;
-    foreach (const PDocumentLine& line, list) {
-        result.append(line->lineText);
+    result.reserve(mLines.count());
+    for (const PDocumentLine& line:mLines) {
+        result.append(lineText(line));
     }
     return result;
 }
@@ -318,8 +327,8 @@ int Document::getTextLength()
 {
     QMutexLocker locker(&mMutex);
     int Result = 0;
-    foreach (const PDocumentLine& line, mLines ) {
-        Result += line->lineText.length();
+    for (const PDocumentLine& line:mLines) {
+        Result += lineText(line).length();
         if (mNewlineType == NewlineType::Windows) {
             Result += 2;
         } else {
@@ -415,13 +424,12 @@ void Document::deleteAt(int index)
 QString Document::getTextStr() const
 {
     QString result;
-    for (int i=0;i<mLines.count()-1;i++) {
-        const PDocumentLine& line = mLines[i];
-        result.append(line->lineText);
-        result.append(lineBreak());
-    }
-    if (mLines.length()>0) {
-        result.append(mLines.back()->lineText);
+    int i=0;
+    for (const PDocumentLine& line:mLines) {
+        if (i>0)
+            result.append(lineBreak());
+        result.append(lineText(line));
+        i++;
     }
     return result;
 }
@@ -437,6 +445,7 @@ void Document::putLine(int index, const QString &s, bool notify) {
         beginUpdate();
         int oldColumns = mLines[index]->columns;
         mLines[index]->lineText = s;
+        mLines[index]->rawStart = -1;
         calculateLineColumns(index);
         if (mIndexOfLongestLine == index && oldColumns>mLines[index]->columns )
             mIndexOfLongestLine = -1;
@@ -462,7 +471,7 @@ int Document::calculateLineColumns(int Index)
 {
     PDocumentLine line = mLines[Index];
 
-    line->columns = stringColumns(line->lineText,0);
+    line->columns = stringColumns(lineText(line),0);
     return line->columns;
 }
 
@@ -482,8 +491,7 @@ void Document::insertLines(int index, int numLines)
     PDocumentLine line;
     mLines.insert(index,numLines,line);
     for (int i=index;i<index+numLines;i++) {
-        line = std::make_shared<DocumentLine>();
-        mLines[i]=line;
+        mLines[i] = std::make_shared<DocumentLine>();
     }
     emit inserted(index,numLines);
 }
@@ -518,6 +526,94 @@ bool Document::tryLoadFileByEncoding(QByteArray encodingName, QFile& file) {
     return true;
 }
 
+bool Document::tryLoadLargeFile(QFile &file, const QByteArray &encoding, QByteArray &realEncoding)
+{
+    //only utf-8 (and ascii) files can be split into lines before decoding
+    if (encoding != ENCODING_AUTO_DETECT
+            && encoding != ENCODING_UTF8
+            && encoding != ENCODING_UTF8_BOM
+            && encoding != ENCODING_ASCII)
+        return false;
+    file.reset();
+    QByteArray data = file.readAll();
+    qint64 start = 0;
+    if (data.startsWith("\xEF\xBB\xBF")) {
+        start = 3;
+    } else if (data.startsWith("\xFF\xFE")) {
+        return false;
+    }
+    QTextCodec* codec = QTextCodec::codecForName(ENCODING_UTF8);
+    if (!codec)
+        return false;
+    if (encoding == ENCODING_AUTO_DETECT) {
+        if (start>0) {
+            realEncoding = ENCODING_UTF8_BOM;
+        } else if (isTextAllAscii(data)) {
+            realEncoding = ENCODING_ASCII;
+        } else {
+            realEncoding = ENCODING_UTF8;
+        }
+        if (realEncoding != ENCODING_ASCII) {
+            //validate in chunks, so the whole file is never decoded at once
+            const int chunkSize = 1024*1024;
+            QTextCodec::ConverterState state;
+            for (qint64 pos=start; pos<data.length(); pos+=chunkSize) {
+                codec->toUnicode(data.constData()+pos, std::min<qint64>(chunkSize,data.length()-pos), &state);
+                if (state.invalidChars>0)
+                    return false;
+            }
+            if (state.remainingChars>0)
+                return false;
+        }
+    } else {
+        realEncoding = encoding;
+    }
+    internalClear();
+    mRawText = data;
+    mLargeFile = true;
+    const char* buf = mRawText.constData();
+    qint64 size = mRawText.length();
+    qint64 pos = start;
+    bool firstLine = true;
+    while (pos<size) {
+        const char* p = (const char*)memchr(buf+pos, '\n', size-pos);
+        qint64 end = p ? (p-buf) : size;
+        qint64 lineEnd = end;
+        if (lineEnd>pos && buf[lineEnd-1]=='\r')
+            lineEnd--;
+        if (firstLine) {
+            if (!p) {
+                if (lineEnd<end)
+                    mNewlineType = NewlineType::MacOld;
+            } else if (lineEnd<end) {
+                mNewlineType = NewlineType::Windows;
+            } else {
+                mNewlineType = NewlineType::Unix;
+            }
+            firstLine = false;
+        }
+        PDocumentLine line = std::make_shared<DocumentLine>();
+        line->rawStart = pos;
+        line->rawLength = lineEnd - pos;
+        mLines.append(line);
+        pos = end + 1;
+    }
+    return true;
+}
+
+QString Document::lineText(const PDocumentLine &line) const
+{
+    if (line->rawStart<0)
+        return line->lineText;
+    return QString::fromUtf8(mRawText.constData()+line->rawStart, line->rawLength);
+}
+
+bool Document::largeFile()
+{
+    QMutexLocker locker(&mMutex);
+    return mLargeFile;
+}
+
 void Document::loadUTF16BOMFile(QFile &file)
 {
     QTextCodec* codec=QTextCodec::codecForName(ENCODING_UTF16);
@@ -572,6 +668,20 @@ void Document::setFontMetrics(const QFont &newFont, const QFont& newNonAsciiFont
     mFontMetrics = QFontMetrics(newFont);
     mCharWidth =  mFontMetrics.horizontalAdvance("M");
     mNonAsciiFontMetrics = QFontMetrics(newNonAsciiFont);
+    resetCharColumnsCache();
+}
+
+void Document::resetCharColumnsCache()
+{
+    mCharColumnsCache.clear();
+    mCharColumnsCache.resize(256);
+    mAsciiSingleColumn = true;
+    for (ushort ch=33;ch<127;ch++) {
+        if (charColumns(QChar(ch))!=1) {
+            mAsciiSingleColumn = false;
+            break;
+        }
+    }
 }
 
 void Document::setTabWidth(int newTabWidth)
@@ -596,6 +706,8 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
         endUpdate();
     });
     mIndexOfLongestLine = -1;
+    if (file.size()>=LargeFileSize && tryLoadLargeFile(file, encoding, realEncoding))
+        return;
     //test for utf8 / utf 8 bom
     if (encoding == ENCODING_AUTO_DETECT) {
         if (file.atEnd()) {
@@ -767,8 +879,8 @@ void Document::saveToFile(QFile &file, const QByteArray& encoding,
     }
     bool allAscii = true;
     QByteArray data;
-    for (PDocumentLine& line:mLines) {
-        QString text = line->lineText+lineBreak();
+    for (const PDocumentLine& line:mLines) {
+        QString text = lineText(line)+lineBreak();
         data = codec->fromUnicode(text);
         if (allAscii) {
             allAscii = (data==text.toLatin1());
@@ -793,6 +905,10 @@ int Document::stringColumns(const QString &line, int colsBefore) const
     int charCols;
     for (int i=0;i<line.length();i++) {
         QChar ch = line[i];
+        if (mAsciiSingleColumn && ch.unicode()<127 && ch!='\t') {
+            columns++;
+            continue;
+        }
         if (ch == '\t') {
             charCols = mTabWidth - columns % mTabWidth;
         } else {
@@ -807,6 +923,17 @@ int Document::charColumns(QChar ch) const
 {
     if (ch.unicode()<=32)
         return 1;
+    QVector<qint8>& block = mCharColumnsCache[ch.unicode() >> 8];
+    if (block.isEmpty())
+        block.fill(-1,256);
+    qint8& columns = block[ch.unicode() & 0xFF];
+    if (columns<0)
+        columns = std::min(measureCharColumns(ch),127);
+    return columns;
+}
+
+int Document::measureCharColumns(QChar ch) const
+{
     int width;
     if (ch.unicode()<0xFF)
         width = mFontMetrics.horizontalAdvance(ch);
@@ -853,6 +980,8 @@ void Document::internalClear()
         emit deleted(0,oldCount);
         endUpdate();
     }
+    mRawText.clear();
+    mLargeFile = false;
 }
 
 NewlineType Document::getNewlineType()
@@ -877,10 +1006,8 @@ void Document::resetColumns()
 {
     QMutexLocker locker(&mMutex);
     mIndexOfLongestLine = -1;
-    if (mLines.count() > 0 ) {
-        for (int i=0;i<mLines.size();i++) {
-            mLines[i]->columns = -1;
-        }
+    for (const PDocumentLine& line:mLines) {
+        line->columns = -1;
     }
 }
 
@@ -888,7 +1015,7 @@ void Document::invalidAllLineColumns()
 {
     QMutexLocker locker(&mMutex);
     mIndexOfLongestLine = -1;
-    for (PDocumentLine& line:mLines) {
+    for (const PDocumentLine& line:mLines) {
         line->columns = -1;
     }
 }
@@ -896,7 +1023,9 @@ void Document::invalidAllLineColumns()
 DocumentLine::DocumentLine():
     lineText(),
     syntaxState(),
-    columns(-1)
+    columns(-1),
+    rawStart(-1),
+    rawLength(0)
 {
 }
 
@@ -1300,4 +1429,136 @@ int RedoList::itemCount()
     return mItems.count();
 }
 
+DocumentLines::DocumentLines():
+    mCount(0)
+{
+
+}
+
+const PDocumentLine &DocumentLines::operator[](int index) const
+{
+    int block = findBlock(index);
+    return mBlocks[block][index-mBlockStarts[block]];
+}
+
+PDocumentLine &DocumentLines::operator[](int index)
+{
+    int block = findBlock(index);
+    return mBlocks[block][index-mBlockStarts[block]];
+}
+
+const PDocumentLine &DocumentLines::back() const
+{
+    return mBlocks.back().back();
+}
+
+void DocumentLines::append(const PDocumentLine &line)
+{
+    insert(mCount,line);
+}
+
+void DocumentLines::insert(int index, const PDocumentLine &line)
+{
+    insert(index,1,line);
+}
+
+void DocumentLines::insert(int index, int n, const PDocumentLine &line)
+{
+    if (n<=0)
+        return;
+    int block;
+    if (mBlocks.isEmpty()
+            || (index == mCount && mBlocks.back().size()>=MaxBlockSize)) {
+        //appending to a full block, start a new one
+        mBlocks.append(QVector<PDocumentLine>());
+        mBlockStarts.append(mCount);
+        block = mBlocks.size()-1;
+    } else if (index == mCount) {
+        block = mBlocks.size()-1;
+    } else {
+        block = findBlock(index);
+    }
+    mBlocks[block].insert(index-mBlockStarts[block],n,line);
+    mCount+=n;
+    updateBlockStarts(block+1);
+    if (mBlocks[block].size()>MaxBlockSize)
+        splitBlock(block);
+}
+
+void DocumentLines::remove(int index, int n)
+{
+    if (n<=0)
+        return;
+    int block = findBlock(index);
+    int firstBlock = block;
+    int pos = index - mBlockStarts[block];
+    mCount -= n;
+    while (n>0) {
+        int removed = std::min(n, (int)mBlocks[block].size()-pos);
+        if (removed == mBlocks[block].size()) {
+            mBlocks.removeAt(block);
+            mBlockStarts.removeAt(block);
+        } else {
+            mBlocks[block].remove(pos,removed);
+            block++;
+        }
+        n-=removed;
+        pos=0;
+    }
+    updateBlockStarts(firstBlock);
+}
+
+void DocumentLines::removeAt(int index)
+{
+    remove(index,1);
+}
+
+void DocumentLines::clear()
+{
+    mBlocks.clear();
+    mBlockStarts.clear();
+    mCount = 0;
+}
+
+DocumentLines::const_iterator DocumentLines::begin() const
+{
+    return const_iterator(this,0,0);
+}
+
+DocumentLines::const_iterator DocumentLines::end() const
+{
+    return const_iterator(this,mBlocks.size(),0);
+}
+
+int DocumentLines::findBlock(int index) const
+{
+    //last block whose start is <= index
+    auto it = std::upper_bound(mBlockStarts.begin(),mBlockStarts.end(),index);
+    return it - mBlockStarts.begin() - 1;
+}
+
+void DocumentLines::updateBlockStarts(int fromBlock)
+{
+    int start = (fromBlock>0)?mBlockStarts[fromBlock-1]+mBlocks[fromBlock-1].size():0;
+    for (int i=fromBlock;i<mBlocks.size();i++) {
+        mBlockStarts[i]=start;
+        start+=mBlocks[i].size();
+    }
+}
+
+void DocumentLines::splitBlock(int block)
+{
+    QVector<PDocumentLine> lines = mBlocks[block];
+    int n = (lines.size() + MaxBlockSize/2 - 1) / (MaxBlockSize/2);
+    int start = mBlockStarts[block];
+    mBlocks.remove(block);
+    mBlockStarts.remove(block);
+    for (int i=0;i<n;i++) {
+        int first = i*lines.size()/n;
+        int last = (i+1)*lines.size()/n;
+        mBlocks.insert(block+i,lines.mid(first,last-first));
+        mBlockStarts.insert(block+i,start+first);
+    }
+}
+
 }
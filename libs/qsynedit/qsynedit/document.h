@@ -34,6 +34,9 @@ struct DocumentLine {
   QString lineText;
   SyntaxState syntaxState;
   int columns;  //
+  //the line is not decoded yet, its text is in Document's raw buffer (large file)
+  qint64 rawStart;
+  int rawLength;
 public:
   explicit DocumentLine();
   DocumentLine(const DocumentLine&)=delete;
@@ -42,7 +45,65 @@ public:
 
 typedef std::shared_ptr<DocumentLine> PDocumentLine;
 
-typedef QVector<PDocumentLine> DocumentLines;
+//Lines are kept in blocks of at most DocumentLines::MaxBlockSize lines, so
+//inserting/deleting lines only moves the lines of one block, and
+//a line is located by binary searching the blocks' start indexes.
+class DocumentLines {
+public:
+    static const int MaxBlockSize = 512;
+    class const_iterator {
+    public:
+        const_iterator(const DocumentLines* lines, int block, int pos):
+            mLines(lines),mBlock(block),mPos(pos) {}
+        const PDocumentLine& operator*() const {
+            return mLines->mBlocks[mBlock][mPos];
+        }
+        const_iterator& operator++() {
+            mPos++;
+            if (mPos>=mLines->mBlocks[mBlock].size()) {
+                mBlock++;
+                mPos=0;
+            }
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const {
+            return mBlock == other.mBlock && mPos == other.mPos;
+        }
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    private:
+        const DocumentLines* mLines;
+        int mBlock;
+        int mPos;
+    };
+
+    DocumentLines();
+    int count() const { return mCount; }
+    int size() const { return mCount; }
+    int length() const { return mCount; }
+    bool isEmpty() const { return mCount==0; }
+    const PDocumentLine& operator[](int index) const;
+    PDocumentLine& operator[](int index);
+    const PDocumentLine& back() const;
+    void append(const PDocumentLine& line);
+    void insert(int index, const PDocumentLine& line);
+    void insert(int index, int n, const PDocumentLine& line);
+    void remove(int index, int n);
+    void removeAt(int index);
+    void clear();
+    const_iterator begin() const;
+    const_iterator end() const;
+private:
+    int findBlock(int index) const;
+    void updateBlockStarts(int fromBlock);
+    void splitBlock(int block);
+private:
+    QVector<QVector<PDocumentLine>> mBlocks;
+    //index of the first line in each block
+    QVector<int> mBlockStarts;
+    int mCount;
+};
 
 typedef std::shared_ptr<DocumentLines> PDocumentLines;
 
@@ -93,6 +154,7 @@ public:
     void insertLines(int index, int numLines);
 
     void loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding);
+    bool largeFile();
     void saveToFile(QFile& file, const QByteArray& encoding,
                     const QByteArray& defaultEncoding, QByteArray& realEncoding);
     int stringColumns(const QString& line, int colsBefore) const;
@@ -133,7 +195,11 @@ protected:
     void putTextStr(const QString& text);
     void internalClear();
 private:
+    void resetCharColumnsCache();
+    int measureCharColumns(QChar ch) const;
     bool tryLoadFileByEncoding(QByteArray encodingName, QFile& file);
+    bool tryLoadLargeFile(QFile& file, const QByteArray& encoding, QByteArray& realEncoding);
+    QString lineText(const PDocumentLine& line) const;
     void loadUTF16BOMFile(QFile& file);
     void loadUTF32BOMFile(QFile& file);
     void saveUTF16File(QFile& file, QTextCodec* codec);
@@ -148,12 +214,19 @@ private:
     QFontMetrics mNonAsciiFontMetrics;
     int mTabWidth;
     int mCharWidth;
+    //columns of each BMP char, in blocks of 256 chars filled when first used (-1 if not measured yet)
+    mutable QVector<QVector<qint8>> mCharColumnsCache;
+    //all printable ascii chars take one column
+    bool mAsciiSingleColumn;
     //int mCount;
     //int mCapacity;
     NewlineType mNewlineType;
     bool mAppendNewLineAtEOF;
     int mIndexOfLongestLine;
     int mUpdateCount;
+    //raw (utf-8) content of the large file, lines are decoded when used
+    QByteArray mRawText;
+    bool mLargeFile;
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
     QRecursiveMutex mMutex;
 #else
@@ -44,6 +44,8 @@
 namespace QSynedit {
 QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
     mEditingCount{0},
+    mScanFromLine{-1},
+    mScanToLine{-1},
     mDropped{false},
     mWheelAccumulatedDeltaX{0},
     mWheelAccumulatedDeltaY{0}
@@ -1919,7 +1921,7 @@ void QSynEdit::endEditing()
     if (mEditingCount==0) {
         if (!mUndoing)
             mUndoList->endBlock();
-        reparseDocument();
+        scanDirtyLines();
     }
     decPaintLock();
 }
@@ -3327,15 +3329,12 @@ void QSynEdit::updateModifiedStatus()
         emit statusChanged(StatusChange::scModifyChanged);
 }
 
-void QSynEdit::scanFrom(int index)
+int QSynEdit::scanFrom(int index, int canStopIndex, int mustStopIndex)
 {
-    if (mEditingCount>0)
-        return;
-
     SyntaxState state;
     int idx = std::max(0,index);
     if (idx >= mDocument->count())
-        return;
+        return mDocument->count()-1;
 
     if (idx == 0) {
         mSyntaxer->resetState();
@@ -3346,12 +3345,56 @@ void QSynEdit::scanFrom(int index)
         mSyntaxer->setLine(mDocument->getLine(idx), idx);
         mSyntaxer->nextToEol();
         state = mSyntaxer->getState();
+        //the following lines are parsed from the same state, no need to rescan them
+        if (idx > canStopIndex && state == mDocument->getSyntaxState(idx))
+            return idx;
         mDocument->setSyntaxState(idx,state);
+        if (idx == mustStopIndex)
+            return idx;
         idx ++ ;
     } while (idx < mDocument->count());
+    return mDocument->count()-1;
+}
+
+void QSynEdit::markLinesDirty(int fromLine, int toLine)
+{
+    if (mScanFromLine<0) {
+        mScanFromLine = fromLine;
+        mScanToLine = toLine;
+    } else {
+        mScanFromLine = std::min(mScanFromLine, fromLine);
+        mScanToLine = std::max(mScanToLine, toLine);
+    }
+}
+
+void QSynEdit::scanDirtyLines()
+{
+    if (mScanFromLine<0)
+        return;
+    int fromLine = mScanFromLine;
+    int toLine = mScanToLine;
+    mScanFromLine = -1;
+    mScanToLine = -1;
+    if (!mSyntaxer || mDocument->count() == 0)
+        return;
+    int lastLine;
+    if (mDocument->largeFile()) {
+        //only scan to the bottom of the window, the rest is scanned when scrolled into view
+        int bottomLine = std::max(fromLine, rowToLine(mTopLine + mLinesInWindow) - 1);
+        lastLine = scanFrom(fromLine, std::min(toLine, bottomLine), bottomLine);
+        if (lastLine == bottomLine && lastLine < mDocument->count()-1)
+            markLinesDirty(lastLine+1, std::max(toLine, lastLine));
+    } else
+        lastLine = scanFrom(fromLine, toLine);
     if (mUseCodeFolding)
-        rescanFolds();
-    return ;
+        rescanFoldsInRange(fromLine, lastLine);
+}
+
+void QSynEdit::scanDirtyLinesInWindow()
+{
+    //lines of large files are scanned when they come into view
+    if (mEditingCount==0 && mScanFromLine>=0 && mDocument->largeFile())
+        scanDirtyLines();
 }
 
 void QSynEdit::reparseLine(int line)
@@ -3372,10 +3415,23 @@ void QSynEdit::reparseLine(int line)
     mSyntaxer->nextToEol();
     SyntaxState iRange = mSyntaxer->getState();
     mDocument->setSyntaxState(line,iRange);
+    //lines after it are not rescanned yet
+    markLinesDirty(line, line);
 }
 
 void QSynEdit::reparseDocument()
 {
+    mScanFromLine = -1;
+    mScanToLine = -1;
+    if (mDocument->largeFile()) {
+        //the stored states are not valid, so lines before the window bottom can't stop the scan
+        markLinesDirty(0, mDocument->count()-1);
+        if (mUseCodeFolding)
+            mAllFoldRanges.clear();
+        scanDirtyLines();
+        invalidateGutter();
+        return;
+    }
     if (mSyntaxer && !mDocument->empty()) {
 //        qint64 begin=QDateTime::currentMSecsSinceEpoch();
         mSyntaxer->resetState();
@@ -3473,6 +3529,52 @@ void QSynEdit::rescanFolds()
     invalidateGutter();
 }
 
+void QSynEdit::rescanFoldsInRange(int fromLine, int toLine)
+{
+    int lineCount = mDocument->count();
+    if (lineCount == 0)
+        return;
+    // The fold starting at the line before the changes may be removed by foldOnListDeleted()
+    fromLine = std::max(0, std::min(fromLine, lineCount-1) - 1);
+    toLine = std::min(std::max(toLine, fromLine), lineCount-1);
+    // Extend the range to lines outside of any block, so no fold crosses its bounds
+    while (fromLine > 0 && mDocument->blockLevel(fromLine-1) > 0)
+        fromLine--;
+    while (toLine < lineCount-1 && mDocument->blockLevel(toLine) > 0)
+        toLine++;
+
+    // Remove old folds in the range (mAllFoldRanges is sorted by fromLine)
+    QMap<QString,PCodeFoldingRange> rangeIndexes;
+    int insertPos = 0;
+    for (int i=mAllFoldRanges.count()-1;i>=0;i--) {
+        PCodeFoldingRange range = mAllFoldRanges[i];
+        if (range->fromLine - 1 > toLine)
+            continue;
+        if (range->fromLine - 1 < fromLine) {
+            insertPos = i + 1;
+            break;
+        }
+        if (range->collapsed)
+            rangeIndexes.insert(QString("%1-%2").arg(range->fromLine).arg(range->toLine),range);
+        mAllFoldRanges.remove(i);
+    }
+
+    PCodeFoldingRanges newFoldRanges = std::make_shared<CodeFoldingRanges>();
+    PCodeFoldingRanges parentFoldRanges = newFoldRanges;
+    findSubFoldRange(newFoldRanges, parentFoldRanges, PCodeFoldingRange(), fromLine, toLine);
+    for (int i = 0; i< newFoldRanges->count();i++) {
+        PCodeFoldingRange range = newFoldRanges->range(i);
+        PCodeFoldingRange oldRange = rangeIndexes.value(QString("%1-%2").arg(range->fromLine).arg(range->toLine),
+                                                         PCodeFoldingRange());
+        if (oldRange) {
+            range->collapsed = true;
+            range->linesCollapsed = oldRange->linesCollapsed;
+        }
+        mAllFoldRanges.insert(insertPos + i, range);
+    }
+    invalidateGutter();
+}
+
 static void null_deleter(CodeFoldingRanges *) {}
 
 void QSynEdit::rescanForFoldRanges()
@@ -3521,7 +3623,7 @@ void QSynEdit::scanForFoldRanges(PCodeFoldingRanges topFoldRanges)
     PCodeFoldingRanges parentFoldRanges = topFoldRanges;
 //    qint64 begin=QDateTime::currentMSecsSinceEpoch();
 
-    findSubFoldRange(topFoldRanges, parentFoldRanges,PCodeFoldingRange());
+    findSubFoldRange(topFoldRanges, parentFoldRanges,PCodeFoldingRange(), 0, mDocument->count()-1);
 //    qint64 diff= QDateTime::currentMSecsSinceEpoch() - begin;
 //    qDebug()<<"?"<<diff;
 }
@@ -3556,15 +3658,15 @@ int QSynEdit::lineHasChar(int Line, int startChar, QChar character, const QStrin
     return -1;
 }
 
-void QSynEdit::findSubFoldRange(PCodeFoldingRanges topFoldRanges, PCodeFoldingRanges& parentFoldRanges, PCodeFoldingRange parent)
+void QSynEdit::findSubFoldRange(PCodeFoldingRanges topFoldRanges, PCodeFoldingRanges& parentFoldRanges, PCodeFoldingRange parent, int startLine, int endLine)
 {
     PCodeFoldingRange  collapsedFold;
-    int line = 0;
+    int line = startLine;
     QString curLine;
     if (!mSyntaxer)
         return;
 
-    while (line < mDocument->count()) { // index is valid for LinesToScan and fLines
+    while (line <= endLine) { // index is valid for LinesToScan and fLines
         // If there is a collapsed fold over here, skip it
 //        collapsedFold = collapsedFoldStartAtLine(line + 1); // only collapsed folds remain
 //        if (collapsedFold) {
@@ -3853,6 +3955,7 @@ void QSynEdit::onScrolled(int)
 {
     mLeftChar = horizontalScrollBar()->value();
     mTopLine = verticalScrollBar()->value();
+    scanDirtyLinesInWindow();
     invalidate();
 }
 
@@ -5954,7 +6057,7 @@ void QSynEdit::endEditingWithoutUndo()
 {
     mEditingCount--;
     if (mEditingCount==0)
-        reparseDocument();
+        scanDirtyLines();
 }
 
 bool QSynEdit::isIdentChar(const QChar &ch)
@@ -6102,6 +6205,12 @@ void QSynEdit::resizeEvent(QResizeEvent *)
 //    mContentImage = image;
 
     onSizeOrFontChanged(false);
+    scanDirtyLinesInWindow();
+}
+
+void QSynEdit::showEvent(QShowEvent *)
+{
+    scanDirtyLinesInWindow();
 }
 
 void QSynEdit::timerEvent(QTimerEvent *event)
@@ -6622,9 +6731,20 @@ void QSynEdit::onLinesDeleted(int index, int count)
 {
     if (mUseCodeFolding)
         foldOnListDeleted(index + 1, count);
-    if (mSyntaxer && mDocument->count() > 0) {
-        scanFrom(index);
-    }
+    if (mScanFromLine>=0) {
+        if (mScanFromLine >= index + count)
+            mScanFromLine -= count;
+        else if (mScanFromLine > index)
+            mScanFromLine = index;
+        if (mScanToLine >= index + count)
+            mScanToLine -= count;
+        else if (mScanToLine >= index)
+            mScanToLine = index - 1;
+    }
+    //line index must be rescanned, but the scan can stop at it if its state is not changed
+    markLinesDirty(index, index - 1);
+    if (mEditingCount==0)
+        scanDirtyLines();
     invalidateLines(index + 1, INT_MAX);
     invalidateGutterLines(index + 1, INT_MAX);
 }
@@ -6633,18 +6753,24 @@ void QSynEdit::onLinesInserted(int index, int count)
 {
     if (mUseCodeFolding)
         foldOnListInserted(index + 1, count);
-    if (mSyntaxer && mDocument->count() > 0) {
-          scanFrom(index);
+    if (mScanFromLine>=0) {
+        if (mScanFromLine >= index)
+            mScanFromLine += count;
+        if (mScanToLine >= index)
+            mScanToLine += count;
     }
+    markLinesDirty(index, index + count - 1);
+    if (mEditingCount==0)
+        scanDirtyLines();
     invalidateLines(index + 1, INT_MAX);
     invalidateGutterLines(index + 1, INT_MAX);
 }
 
-void QSynEdit::onLinesPutted(int index, int /*count*/)
+void QSynEdit::onLinesPutted(int index, int count)
 {
-    if (mSyntaxer) {
-        scanFrom(index);
-    }
+    markLinesDirty(index, index + count - 1);
+    if (mEditingCount==0)
+        scanDirtyLines();
     invalidateLines(index + 1, INT_MAX);
 }
 
@@ -501,7 +501,10 @@ private:
     void recalcCharExtent();
     QString expandAtWideGlyphs(const QString& S);
     void updateModifiedStatus();
-    void scanFrom(int index);
+    int scanFrom(int index, int canStopIndex, int mustStopIndex = -1);
+    void markLinesDirty(int fromLine, int toLine);
+    void scanDirtyLines();
+    void scanDirtyLinesInWindow();
     void reparseLine(int line);
     void reparseDocument();
     void uncollapse(PCodeFoldingRange FoldRange);
@@ -512,9 +515,10 @@ private:
     void foldOnListCleared();
     void rescanFolds(); // rescan for folds
     void rescanForFoldRanges();
+    void rescanFoldsInRange(int fromLine, int toLine);
     void scanForFoldRanges(PCodeFoldingRanges topFoldRanges);
     int lineHasChar(int Line, int startChar, QChar character, const QString& tokenAttrName);
-    void findSubFoldRange(PCodeFoldingRanges topFoldRanges,PCodeFoldingRanges& parentFoldRanges, PCodeFoldingRange Parent);
+    void findSubFoldRange(PCodeFoldingRanges topFoldRanges,PCodeFoldingRanges& parentFoldRanges, PCodeFoldingRange Parent, int startLine, int endLine);
     PCodeFoldingRange collapsedFoldStartAtLine(int Line);
     void initializeCaret();
     PCodeFoldingRange foldStartAtLine(int Line) const;
@@ -642,6 +646,8 @@ private:
     CodeFoldingRanges mAllFoldRanges;
     CodeFoldingOptions mCodeFolding;
     int mEditingCount;
+    int mScanFromLine; // first line whose syntax state needs rescan, -1 if none
+    int mScanToLine; // rescan can't stop before this line
     bool mUseCodeFolding;
     bool  mAlwaysShowCaret;
     BufferCoord mBlockBegin;
@@ -753,6 +759,7 @@ friend class QSynEditPainter;
 protected:
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
     void timerEvent(QTimerEvent *event) override;
     bool event(QEvent *event) override;
     void focusInEvent(QFocusEvent *event) override;
@@ -18,7 +18,18 @@
 
 namespace QSynedit {
 
-BasicSearcher::BasicSearcher(QObject *parent):BaseSearcher(parent)
+static inline ushort foldChar(ushort ch)
+{
+    if (ch<128) {
+        if (ch>='A' && ch<='Z')
+            return ch+('a'-'A');
+        return ch;
+    }
+    return QChar::toCaseFolded(ch);
+}
+
+BasicSearcher::BasicSearcher(QObject *parent):BaseSearcher(parent),
+    mUseHorspool(false)
 {
 
 }
@@ -49,16 +60,13 @@ int BasicSearcher::findAll(const QString &text)
         return 0;
     int start=0;
     int next=-1;
+    int patternLen = pattern().length();
     while (true) {
-        if (options().testFlag(ssoMatchCase)) {
-            next = text.indexOf(pattern(),start,Qt::CaseSensitive);
-        } else {
-            next = text.indexOf(pattern(),start,Qt::CaseInsensitive);
-        }
+        next = findNext(text,start);
         if (next<0) {
             break;
         }
-        start = next + pattern().length();
+        start = next + patternLen;
         if (options().testFlag(ssoWholeWord)) {
             if (((next<=0) || isDelimitChar(text[next-1]))
                     &&
@@ -79,4 +87,83 @@ QString BasicSearcher::replace(const QString &, const QString &aReplacement)
     return aReplacement;
 }
 
+void BasicSearcher::setPattern(const QString &value)
+{
+    BaseSearcher::setPattern(value);
+    preparePattern();
+}
+
+void BasicSearcher::setOptions(const SearchOptions &options)
+{
+    BaseSearcher::setOptions(options);
+    preparePattern();
+}
+
+void BasicSearcher::preparePattern()
+{
+    QString s = pattern();
+    bool matchCase = options().testFlag(ssoMatchCase);
+    //chars outside the BMP don't fold one unit at a time, leave them to QString::indexOf()
+    mUseHorspool = !s.isEmpty();
+    for (int i=0;i<s.length();i++) {
+        if (s[i].isSurrogate()) {
+            mUseHorspool = false;
+            break;
+        }
+    }
+    if (!mUseHorspool) {
+        mFoldedPattern.clear();
+        return;
+    }
+    if (!matchCase) {
+        for (int i=0;i<s.length();i++)
+            s[i] = QChar(foldChar(s[i].unicode()));
+    }
+    mFoldedPattern = s;
+    int len = s.length();
+    for (int i=0;i<256;i++)
+        mShifts[i] = len;
+    for (int i=0;i<len-1;i++)
+        mShifts[s[i].unicode() & 0xFF] = len-1-i;
+}
+
+int BasicSearcher::findNext(const QString &text, int start) const
+{
+    bool matchCase = options().testFlag(ssoMatchCase);
+    if (!mUseHorspool)
+        return text.indexOf(pattern(),start,matchCase?Qt::CaseSensitive:Qt::CaseInsensitive);
+    const ushort* p = mFoldedPattern.utf16();
+    int len = mFoldedPattern.length();
+    const ushort* t = text.utf16();
+    int last = text.length() - len;
+    ushort lastCh = p[len-1];
+    int i = start;
+    if (matchCase) {
+        while (i<=last) {
+            ushort ch = t[i+len-1];
+            if (ch == lastCh) {
+                int j = len-2;
+                while (j>=0 && t[i+j]==p[j])
+                    j--;
+                if (j<0)
+                    return i;
+            }
+            i += mShifts[ch & 0xFF];
+        }
+    } else {
+        while (i<=last) {
+            ushort ch = foldChar(t[i+len-1]);
+            if (ch == lastCh) {
+                int j = len-2;
+                while (j>=0 && foldChar(t[i+j])==p[j])
+                    j--;
+                if (j<0)
+                    return i;
+            }
+            i += mShifts[ch & 0xFF];
+        }
+    }
+    return -1;
+}
+
 }
@@ -33,8 +33,18 @@ public:
     int resultCount() override;
     int findAll(const QString &text) override;
     QString replace(const QString &aOccurrence, const QString &aReplacement) override;
+    void setPattern(const QString &value) override;
+    void setOptions(const SearchOptions &options) override;
+private:
+    void preparePattern();
+    int findNext(const QString& text, int start) const;
 private:
     QList<int> mResults;
+    //case folded (if not match case) pattern and its Horspool shift table,
+    //indexed by the low byte of the char
+    QString mFoldedPattern;
+    bool mUseHorspool;
+    int mShifts[256];
 };
 }
 
@@ -31,12 +31,20 @@ using std::vector;
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/wait.h>
+#include <signal.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
 #define MAX_COMMAND_LENGTH 32768
 #define MAX_ERROR_LENGTH 2048
+//peak rss (in percent of the memory limit) from which a crash is taken as hitting the limit
+#define MEMORY_LIMIT_HIT_PERCENT 90
 
 enum RunProgramFlag {
     RPF_PAUSE_CONSOLE =     0x0001,
-    RPF_REDIRECT_INPUT =    0x0002
+    RPF_REDIRECT_INPUT =    0x0002,
+    RPF_RUN_CASE =          0x0004
 };
 
 
@@ -152,8 +160,92 @@ int ExecuteCommand(vector<string>& command,bool reInp, long int &peakMemory) {
     return 0;
 }
 
+// Run a problem case for the IDE. stdin/stdout are the IDE's pipes and are left untouched;
+// cpu time (ms), peak rss (kb), the wait status and whether the memory cap was hit
+// are written to the result file.
+int RunCase(int argc, char** argv) {
+    if (argc < 6) {
+        fprintf(stderr,"Usage: consolepauser %d <result_file> <time_limit_ms> <memory_limit_kb> <filename> <parameters>\n",RPF_RUN_CASE);
+        return EXIT_FAILURE;
+    }
+    const char* resultFile = argv[2];
+    long timeLimit = atol(argv[3]);
+    long memoryLimit = atol(argv[4]);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork failed!");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+#ifdef __linux__
+        //don't leave the program running if the ide kills us
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+        struct rlimit limit;
+        if (timeLimit>0) {
+            //rlimit is in seconds; give some slack so the ide can still report the exact time
+            limit.rlim_cur = (timeLimit+999)/1000+1;
+            limit.rlim_max = limit.rlim_cur+1;
+            setrlimit(RLIMIT_CPU,&limit);
+        }
+        if (memoryLimit>0) {
+            //data segment and private mappings, i.e. what the program allocates itself
+            limit.rlim_cur = (rlim_t)memoryLimit*1024;
+            limit.rlim_max = limit.rlim_cur;
+            setrlimit(RLIMIT_DATA,&limit);
+        }
+        execv(argv[5],argv+5);
+        printf("Failed to start command %s!\n",argv[5]);
+        printf("errno %d: %s\n",errno,strerror(errno));
+        exit(-1);
+    }
+    int status;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage)==-1) {
+        if (errno!=EINTR) {
+            perror("wait4 failed!");
+            return EXIT_FAILURE;
+        }
+    }
+    long cpuTime = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)*1000
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)/1000;
+#ifdef __APPLE__
+    long peakMemory = usage.ru_maxrss/1024;
+#else
+    long peakMemory = usage.ru_maxrss;
+#endif
+    //a crash only counts as hitting the cap when the program was close to it;
+    //other crashes are runtime errors
+    int memoryLimitHit = 0;
+    if (memoryLimit>0 && WIFSIGNALED(status)
+            && peakMemory*100 >= memoryLimit*MEMORY_LIMIT_HIT_PERCENT) {
+        switch (WTERMSIG(status)) {
+        case SIGSEGV:
+        case SIGABRT:
+        case SIGBUS:
+            memoryLimitHit = 1;
+            break;
+        }
+    }
+    FILE* file = fopen(resultFile,"w");
+    if (file) {
+        fprintf(file,"%ld %ld %d %d\n",cpuTime,peakMemory,status,memoryLimitHit);
+        fclose(file);
+    }
+    if (WIFSIGNALED(status)) {
+        //die the same way, so the ide sees the crash
+        signal(WTERMSIG(status),SIG_DFL);
+        raise(WTERMSIG(status));
+    }
+    if (WIFEXITED(status))
+        return WEXITSTATUS(status);
+    return EXIT_FAILURE;
+}
+
 int main(int argc, char** argv) {
     char* sharedMemoryId;
+    if (argc > 1 && (atoi(argv[1]) & RPF_RUN_CASE))
+        return RunCase(argc,argv);
     // First make sure we aren't going to read nonexistent arrays
     if(argc < 4) {
         printf("\n--------------------------------");
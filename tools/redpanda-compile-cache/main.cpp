@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QVector>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+//Usage: redpanda-compile-cache <cache dir> <max size in MB> <compiler> [compiler arguments...]
+//
+//Compiles a single C/C++ source file to an object (-c) or assembly (-S) file,
+//reusing the output of a previous compile when the compiler, the arguments and
+//the preprocessed source are the same. Commands that can't be cached (linking,
+//-E, dependency files...) are passed through to the compiler.
+
+#define CACHE_VERSION 2
+#define STATS_FILE "stats"
+#define LOCK_FILE "lock"
+#define LOCK_TIMEOUT 10000
+#define OUTPUT_SUFFIX ".out"
+#define STDERR_SUFFIX ".stderr"
+//evict down to this percentage of the max size, so we don't evict on every store
+#define EVICT_TARGET_PERCENT 90
+
+struct CompileCommand {
+    QString sourceFile;
+    QString outputFile;
+    QStringList preprocessArguments; // arguments without "-o <file>"
+    bool cacheable;
+};
+
+struct CacheEntry {
+    QString filename;
+    qint64 size;
+    qint64 lastUsed;
+};
+
+static void writeOutput(FILE* stream, const QByteArray& data)
+{
+    if (!data.isEmpty()) {
+        fwrite(data.constData(), 1, data.size(), stream);
+        fflush(stream);
+    }
+}
+
+static int runCompiler(const QString& compiler, const QStringList& arguments)
+{
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedChannels);
+    process.start(compiler, arguments);
+    if (!process.waitForStarted()) {
+        fprintf(stderr, "Can't start compiler \"%s\"\n", compiler.toLocal8Bit().constData());
+        return -1;
+    }
+    process.waitForFinished(-1);
+    if (process.exitStatus()!=QProcess::NormalExit)
+        return -1;
+    return process.exitCode();
+}
+
+static bool isSourceFile(const QString& filename)
+{
+    static const QStringList suffixes{"c","cc","cp","cpp","cxx","c++"};
+    return suffixes.contains(QFileInfo(filename).suffix().toLower());
+}
+
+static CompileCommand parseCommand(const QStringList& arguments)
+{
+    //options whose value is the next argument
+    static const QStringList optionsWithValue{
+        "-x","-include","-imacros","-isystem","-idirafter","-iquote","-iprefix",
+        "-I","-L","-D","-U","-l","-Xlinker","-Xassembler","-Xpreprocessor"};
+    CompileCommand command;
+    command.cacheable = true;
+    //a linked executable also depends on the libraries, which are not in the key
+    bool compileOnly = false;
+    for (int i=0;i<arguments.count();i++) {
+        const QString& arg = arguments[i];
+        if (arg == "-c" || arg == "-S") {
+            compileOnly = true;
+            command.preprocessArguments.append(arg);
+        } else if (arg == "-o") {
+            if (i+1>=arguments.count())
+                command.cacheable = false;
+            else
+                command.outputFile = arguments[++i];
+        } else if (arg.startsWith("-o")) {
+            command.outputFile = arg.mid(2);
+        } else if (arg == "-E" || arg == "-" || arg.startsWith("-M")
+                   || arg.startsWith("-save-temps") || arg.startsWith("@")) {
+            command.cacheable = false;
+            command.preprocessArguments.append(arg);
+        } else if (optionsWithValue.contains(arg)) {
+            command.preprocessArguments.append(arg);
+            if (i+1<arguments.count())
+                command.preprocessArguments.append(arguments[++i]);
+        } else if (arg.startsWith('-')) {
+            command.preprocessArguments.append(arg);
+        } else {
+            //input file; only a single c/c++ source can be cached
+            if (!isSourceFile(arg) || !command.sourceFile.isEmpty())
+                command.cacheable = false;
+            command.sourceFile = arg;
+            command.preprocessArguments.append(arg);
+        }
+    }
+    if (!compileOnly || command.sourceFile.isEmpty() || command.outputFile.isEmpty())
+        command.cacheable = false;
+    return command;
+}
+
+static QString compilerPath(const QString& compiler)
+{
+    QFileInfo info(compiler);
+    if (info.isAbsolute() || compiler.contains('/') || compiler.contains('\\'))
+        return info.absoluteFilePath();
+    QString path = QStandardPaths::findExecutable(compiler);
+    return path.isEmpty()?compiler:path;
+}
+
+static QString cacheKey(const QString& compiler, const CompileCommand& command, const QByteArray& preprocessed)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(CACHE_VERSION));
+    //the compiler is identified by its path, size and modification time
+    QString path = compilerPath(compiler);
+    QFileInfo info(path);
+    hash.addData(path.toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    //debug info records the working directory
+    hash.addData(QDir::currentPath().toUtf8());
+    foreach (const QString& arg, command.preprocessArguments) {
+        hash.addData(arg.toUtf8());
+        hash.addData("\0", 1);
+    }
+    hash.addData(preprocessed);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+static void readStats(const QString& statsFile, qint64& hits, qint64& misses, qint64& size)
+{
+    hits = 0;
+    misses = 0;
+    size = 0;
+    QFile file(statsFile);
+    if (!file.open(QFile::ReadOnly))
+        return;
+    QList<QByteArray> values = file.readAll().simplified().split(' ');
+    if (values.count()>=3) {
+        hits = values[0].toLongLong();
+        misses = values[1].toLongLong();
+        size = values[2].toLongLong();
+    }
+}
+
+static void writeStats(const QString& statsFile, qint64 hits, qint64 misses, qint64 size)
+{
+    QFile file(statsFile);
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        file.write(QString("%1 %2 %3\n").arg(hits).arg(misses).arg(size).toLatin1());
+    }
+}
+
+//remove the least recently used entries until the cache is below the target size
+static qint64 evict(const QDir& cacheDir, qint64 maxSize)
+{
+    QVector<CacheEntry> entries;
+    qint64 totalSize = 0;
+    QDirIterator iter(cacheDir.absolutePath(), QStringList{QString("*") + OUTPUT_SUFFIX},
+                      QDir::Files, QDirIterator::Subdirectories);
+    while (iter.hasNext()) {
+        QString filename = iter.next();
+        QFileInfo info(filename);
+        QString stderrFile = filename.left(filename.length()-strlen(OUTPUT_SUFFIX)) + STDERR_SUFFIX;
+        CacheEntry entry{filename, info.size()+QFileInfo(stderrFile).size(),
+                    info.lastModified().toMSecsSinceEpoch()};
+        totalSize += entry.size;
+        entries.append(entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const CacheEntry& e1, const CacheEntry& e2) {
+        return e1.lastUsed < e2.lastUsed;
+    });
+    qint64 targetSize = maxSize / 100 * EVICT_TARGET_PERCENT;
+    for (const CacheEntry& entry:entries) {
+        if (totalSize <= targetSize)
+            break;
+        QString base = entry.filename.left(entry.filename.length()-strlen(OUTPUT_SUFFIX));
+        QFile::remove(entry.filename);
+        QFile::remove(base + STDERR_SUFFIX);
+        totalSize -= entry.size;
+    }
+    return totalSize;
+}
+
+//update statistics, and add the size of the newly stored entry
+static void updateStats(const QDir& cacheDir, qint64 maxSize, bool hit, qint64 addedSize)
+{
+    QLockFile lock(cacheDir.absoluteFilePath(LOCK_FILE));
+    if (!lock.tryLock(LOCK_TIMEOUT))
+        return;
+    QString statsFile = cacheDir.absoluteFilePath(STATS_FILE);
+    qint64 hits, misses, size;
+    readStats(statsFile, hits, misses, size);
+    if (hit)
+        hits++;
+    else
+        misses++;
+    size += addedSize;
+    if (size > maxSize)
+        size = evict(cacheDir, maxSize);
+    writeStats(statsFile, hits, misses, size);
+}
+
+static bool fetchFromCache(const QString& entryBase, const CompileCommand& command)
+{
+    QString outputFile = entryBase + OUTPUT_SUFFIX;
+    if (!QFile::exists(outputFile))
+        return false;
+    QFile::remove(command.outputFile);
+    if (!QFile::copy(outputFile, command.outputFile))
+        return false;
+    //copy() keeps the time of the cached file, let make know the output is new
+    QFile output(command.outputFile);
+    if (output.open(QFile::ReadWrite)) {
+        output.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        output.close();
+    }
+    QFile stderrFile(entryBase + STDERR_SUFFIX);
+    if (stderrFile.open(QFile::ReadOnly))
+        writeOutput(stderr, stderrFile.readAll());
+    //the modification time of the entry is used as its last used time
+    QFile entry(outputFile);
+    if (entry.open(QFile::ReadWrite)) {
+        entry.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        entry.close();
+    }
+    return true;
+}
+
+static qint64 storeToCache(const QString& entryBase, const CompileCommand& command, const QByteArray& errorOutput)
+{
+    QString outputFile = entryBase + OUTPUT_SUFFIX;
+    QString tempFile = outputFile + ".tmp";
+    QFile::remove(tempFile);
+    if (!QFile::copy(command.outputFile, tempFile))
+        return 0;
+    QFile stderrFile(entryBase + STDERR_SUFFIX);
+    if (!stderrFile.open(QFile::WriteOnly | QFile::Truncate)
+            || stderrFile.write(errorOutput)!=errorOutput.size()) {
+        QFile::remove(tempFile);
+        return 0;
+    }
+    stderrFile.close();
+    //rename last, so an entry is never used before it's complete
+    QFile::remove(outputFile);
+    if (!QFile::rename(tempFile, outputFile)) {
+        QFile::remove(tempFile);
+        return 0;
+    }
+    return QFileInfo(outputFile).size() + errorOutput.size();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList arguments = app.arguments();
+    if (arguments.count()<4) {
+        fprintf(stderr, "Usage: %s <cache dir> <max size in MB> <compiler> [arguments...]\n",
+                argv[0]);
+        return -1;
+    }
+    QDir cacheDir(arguments[1]);
+    qint64 maxSize = arguments[2].toLongLong() * 1024 * 1024;
+    QString compiler = arguments[3];
+    QStringList compilerArguments = arguments.mid(4);
+
+    //the compiler may need its own dir in PATH to find its dlls and tools
+    QString compilerDir = QFileInfo(compiler).path();
+    if (compilerDir!=".") {
+        QByteArray path = qgetenv("PATH");
+        qputenv("PATH", QDir::toNativeSeparators(compilerDir).toLocal8Bit()
+                + QDir::listSeparator().toLatin1() + path);
+    }
+
+    CompileCommand command = parseCommand(compilerArguments);
+    if (!command.cacheable || maxSize<=0 || !cacheDir.mkpath("."))
+        return runCompiler(compiler, compilerArguments);
+
+    QProcess preprocessor;
+    preprocessor.start(compiler, command.preprocessArguments + QStringList{"-E"});
+    if (!preprocessor.waitForStarted())
+        return runCompiler(compiler, compilerArguments);
+    preprocessor.waitForFinished(-1);
+    QByteArray preprocessed = preprocessor.readAllStandardOutput();
+    if (preprocessor.exitStatus()!=QProcess::NormalExit || preprocessor.exitCode()!=0) {
+        //let the compiler report the errors
+        return runCompiler(compiler, compilerArguments);
+    }
+
+    QString key = cacheKey(compiler, command, preprocessed);
+    QString subDir = key.left(2);
+    cacheDir.mkpath(subDir);
+    QString entryBase = cacheDir.absoluteFilePath(subDir + "/" + key);
+    if (fetchFromCache(entryBase, command)) {
+        updateStats(cacheDir, maxSize, true, 0);
+        return 0;
+    }
+
+    QProcess process;
+    process.start(compiler, compilerArguments);
+    if (!process.waitForStarted()) {
+        fprintf(stderr, "Can't start compiler \"%s\"\n", compiler.toLocal8Bit().constData());
+        return -1;
+    }
+    process.waitForFinished(-1);
+    QByteArray errorOutput = process.readAllStandardError();
+    writeOutput(stdout, process.readAllStandardOutput());
+    writeOutput(stderr, errorOutput);
+    if (process.exitStatus()!=QProcess::NormalExit)
+        return -1;
+    int exitCode = process.exitCode();
+    qint64 addedSize = 0;
+    if (exitCode == 0 && QFile::exists(command.outputFile))
+        addedSize = storeToCache(entryBase, command, errorOutput);
+    updateStats(cacheDir, maxSize, false, addedSize);
+    return exitCode;
+}
@@ -0,0 +1,33 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+isEmpty(APP_NAME) {
+    APP_NAME = RedPandaCPP
+}
+
+SOURCES += \
+    main.cpp
+
+win32: {
+DEFINES += _WIN32_WINNT=0x0601
+}
+
+isEmpty(PREFIX) {
+    PREFIX = /usr/local
+}
+isEmpty(LIBEXECDIR) {
+    LIBEXECDIR = $${PREFIX}/libexec
+}
+
+win32: {
+    !isEmpty(PREFIX) {
+        target.path = $${PREFIX}
+    }
+}
+
+# Default rules for deployment.
+qnx: target.path = $${LIBEXECDIR}/$${APP_NAME}
+else: unix:!android: target.path = $${LIBEXECDIR}/$${APP_NAME}
+!isEmpty(target.path): INSTALLS += target